@@ -1,3 +1,4 @@
+#include <array>
 #include <iostream>
 
 #include <nautypp/nautypp>
@@ -23,5 +24,9 @@ int main() {
     auto degrees{K_1_5.degree()};
     for(size_t v{0}; v < K_1_5.V(); ++v)
         std::cout << "deg(" << v << ") = " << degrees[v] << std::endl;
+    // same without allocating: the degrees are written into a given array
+    std::array<size_t, 6> degrees_buffer;
+    K_1_5.degree(degrees_buffer);
+    std::cout << "deg(0) = " << degrees_buffer[0] << std::endl;
     return 0;
 }
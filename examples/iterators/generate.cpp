@@ -0,0 +1,32 @@
+#include <iostream>
+#include <map>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Consume the generated graphs in a plain loop instead of a callback
+int main() {
+    NautyParameters params{
+        .connected=true,
+        .V=7,
+        .Vmax=7
+    };
+    std::map<size_t, size_t> counts;
+    for(const Graph& G : Nauty().generate(params))
+        ++counts[G.E()];
+    for(auto [E, count] : counts)
+        std::cout << count << " connected graphs with " << E << " edges" << std::endl;
+
+    // leaving the loop early stops geng
+    for(const Graph& G : Nauty().generate(params)) {
+        if(G.is_planar())
+            continue;
+        std::cout << "First non-planar graph:";
+        for(auto [v, w] : G.edges())
+            std::cout << ' ' << v << '-' << w;
+        std::cout << std::endl;
+        break;
+    }
+    return 0;
+}
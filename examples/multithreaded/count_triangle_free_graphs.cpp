@@ -1,6 +1,5 @@
 #include <atomic>
 #include <iostream>
-#include <vector>
 
 #include <nautypp/nautypp>
 
@@ -8,27 +7,6 @@ using namespace nautypp;
 
 static constexpr int V{6};
 
-static inline bool contains_triangle(const Graph& G) {
-    std::vector<bool> marked(G.V(), false);
-    std::vector<std::pair<Vertex, Vertex>> stack;
-    stack.emplace_back(0, -1);
-    while(not stack.empty()) {
-        auto [v, parent] = stack.back();
-        stack.pop_back();
-        for(auto w : G.neighbours_of(v)) {
-            if(marked[w]) {
-                if(G.are_linked(parent, w))
-                    return true;
-                continue;
-            } else {
-                marked[w] = true;
-                stack.emplace_back(w, v);
-            }
-        }
-    }
-    return false;
-}
-
 static unsigned through_all() {
     NautyParameters params{
         .tree=false,
@@ -41,7 +19,7 @@ static unsigned through_all() {
     std::atomic_uint ret;
     nauty.run_async(
         [&ret](const Graph& G) {
-            if(contains_triangle(G))
+            if(G.has_triangle())
                 return;
             ++ret;
         },
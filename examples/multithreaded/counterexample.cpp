@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Look for a triangle-free graph which is not planar: the run stops as soon
+// as one is found instead of going through every graph up to 12 vertices.
+int main() {
+    NautyParameters params{
+        .triangle_free=true,
+        .V=4,
+        .Vmax=12
+    };
+    std::mutex mutex;
+    std::optional<Graph> found;
+    // give up after a minute, whatever happens
+    std::stop_source timeout;
+    std::jthread watchdog([&timeout](std::stop_token done) {
+        for(int i{0}; i < 60 and not done.stop_requested(); ++i)
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        timeout.request_stop();
+    });
+    Nauty().run_async(
+        [&mutex, &found](Graph& G) {
+            if(G.is_planar())
+                return CallbackStatus::CONTINUE;
+            std::lock_guard lock(mutex);
+            if(not found)  // other workers may find one before stopping
+                found.emplace(std::move(G));
+            return CallbackStatus::STOP;
+        },
+        params,
+        std::thread::hardware_concurrency(), 5'000,
+        timeout.get_token()
+    );
+    watchdog.request_stop();
+    if(not found) {
+        std::cout << "No counterexample found\n";
+        return 1;
+    }
+    std::cout << "Non-planar triangle-free graph on " << found->V() << " vertices:";
+    for(auto [v, w] : found->edges())
+        std::cout << ' ' << v << '-' << w;
+    std::cout << std::endl;
+    return 0;
+}
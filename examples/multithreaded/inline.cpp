@@ -0,0 +1,27 @@
+#include <iostream>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Count the graphs on 10 vertices whose degrees are all even: the callback is
+// much cheaper than copying the graphs to workers, so it runs inside geng
+int main() {
+    NautyParameters params{
+        .connected=false,
+        .V=10,
+        .Vmax=10
+    };
+    reducers::Counter<> nb_eulerian;
+    Nauty().run_inline(
+        [&nb_eulerian](const Graph& G) {
+            for(Vertex v{0}; v < G.V(); ++v)
+                if(G.degree(v) % 2 != 0)
+                    return;
+            ++nb_eulerian;
+        },
+        params
+    );
+    std::cout << nb_eulerian.get() << " graphs with only even degrees" << std::endl;
+    return 0;
+}
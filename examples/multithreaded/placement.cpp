@@ -0,0 +1,30 @@
+#include <iostream>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Pin the producers and the workers on multi-socket machines: every geng
+// instance gets a NUMA node, and the workers it feeds run (and allocate
+// their buffers) on the same node
+int main() {
+    const auto nodes{numa::nodes()};
+    NautyParameters params{
+        .connected=true,
+        .V=10,
+        .Vmax=10,
+        .nb_producers=static_cast<unsigned>(nodes.size()),
+        .placement={.pin=true}
+    };
+    std::cout << nodes.size() << " NUMA node(s)" << std::endl;
+    reducers::Counter<> nb_planar;
+    Nauty().run_async(
+        [&nb_planar](const Graph& G) {
+            if(G.is_planar())
+                ++nb_planar;
+        },
+        params
+    );
+    std::cout << nb_planar.get() << " planar graphs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <iostream>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Statistics on the connected graphs on 8 vertices, gathered from a lambda
+// without any atomic variable nor Callback struct
+int main() {
+    NautyParameters params{
+        .connected=true,
+        .V=8,
+        .Vmax=8
+    };
+    reducers::Counter<> nb_planar;
+    reducers::Histogram<> max_degrees;
+    reducers::Maximum<size_t, size_t> densest_planar;  // number of edges, clique number
+    Nauty().run_async(
+        [&](const Graph& G) {
+            size_t max_degree{0};
+            for(Vertex v{0}; v < G.V(); ++v)
+                max_degree = std::max(max_degree, G.degree(v));
+            max_degrees.add(max_degree);
+            if(G.is_planar()) {
+                ++nb_planar;
+                if(densest_planar.improves(G.E()))
+                    densest_planar.update(G.E(), G.max_clique());
+            }
+        },
+        params
+    );
+    std::cout << nb_planar.get() << " planar graphs" << std::endl;
+    auto densest{densest_planar.get()};
+    std::cout << "Densest planar graphs have " << densest->first << " edges "
+              << "(one of them has clique number " << densest->second << ")" << std::endl;
+    auto histogram{max_degrees.get()};
+    for(size_t d{0}; d < histogram.size(); ++d)
+        std::cout << histogram[d] << " graphs with maximum degree " << d << std::endl;
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Count the graphs on 8 vertices by number of edges
+struct Callback {
+    typedef std::map<size_t, size_t> ResultType;
+
+    Callback() = default;
+
+    // Required by Nauty::merge_shards to rebuild a callback from a shard file
+    Callback(ResultType&& result): counts(std::move(result)) {
+    }
+
+    void operator()(Graph& G) {
+        ++counts[G.E()];
+    }
+
+    void join(Callback&& other) {
+        for(auto [E, count] : other.counts)
+            counts[E] += count;
+    }
+
+    ResultType&& get() {
+        return std::move(counts);
+    }
+
+private:
+    ResultType counts;
+};
+
+static const NautyParameters params{
+    .connected=false,
+    .V=8,
+    .Vmax=8
+};
+
+static void print(const Callback::ResultType& counts) {
+    for(auto [E, count] : counts)
+        std::cout << count << " graphs with " << E << " edges\n";
+}
+
+int main(int argc, char** argv) {
+    std::string mode{argc > 1 ? argv[1] : ""};
+    if(mode == "run" and argc == 5) {
+        // e.g. on host i out of k: ./sharded run i k shard_i.bin
+        Nauty().run_shard<Callback>(
+            params,
+            std::atoi(argv[2]), std::atoi(argv[3]),
+            argv[4]
+        );
+    } else if(mode == "merge" and argc > 2) {
+        // once every shard is done: ./sharded merge shard_*.bin
+        print(Nauty::merge_shards<Callback>({argv+2, argv+argc}));
+    } else {
+        // run 4 shards one after the other and merge them
+        constexpr unsigned nb_shards{4};
+        std::vector<std::string> paths;
+        for(unsigned i{0}; i < nb_shards; ++i) {
+            paths.push_back("shard_" + std::to_string(i) + ".bin");
+            Nauty().run_shard<Callback>(params, i, nb_shards, paths.back());
+        }
+        print(Nauty::merge_shards<Callback>(paths));
+        for(const auto& path : paths)
+            std::remove(path.c_str());
+    }
+    return EXIT_SUCCESS;
+}
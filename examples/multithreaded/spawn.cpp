@@ -0,0 +1,55 @@
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Count graphs by number of edges
+struct Callback {
+    typedef std::map<size_t, size_t> ResultType;
+
+    void operator()(Graph& G) {
+        ++counts[G.E()];
+    }
+
+    void join(Callback&& other) {
+        for(auto [E, count] : other.counts)
+            counts[E] += count;
+    }
+
+    ResultType&& get() {
+        return std::move(counts);
+    }
+
+private:
+    ResultType counts;
+};
+
+static void print(const char* name, const Callback::ResultType& counts) {
+    std::cout << name << ":\n";
+    for(auto [E, count] : counts)
+        std::cout << "  " << count << " graphs with " << E << " edges\n";
+}
+
+int main() {
+    const auto nb_workers{std::max(std::thread::hardware_concurrency() / 2, 1u)};
+    // both enumerations run at the same time, each with its own workers
+    auto all{Nauty().spawn<Callback>(
+        NautyParameters{.connected=false, .V=9, .Vmax=9},
+        nb_workers
+    )};
+    auto triangle_free{Nauty().spawn<Callback>(
+        NautyParameters{.triangle_free=true, .V=11, .Vmax=11},
+        nb_workers
+    )};
+    while(not (all.poll() and triangle_free.poll())) {
+        std::cout << "Still running..." << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+    print("All graphs on 9 vertices", all.get());
+    print("Connected triangle-free graphs on 11 vertices", triangle_free.get());
+    return 0;
+}
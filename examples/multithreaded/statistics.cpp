@@ -0,0 +1,40 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Watch the pipeline while counting the planar graphs on 10 vertices, to see
+// whether the run is limited by geng or by the workers
+int main() {
+    PipelineStatistics statistics(&std::cout);  // summary printed at the end
+    NautyParameters params{
+        .connected=true,
+        .V=10,
+        .Vmax=10,
+        .statistics=&statistics
+    };
+    reducers::Counter<> nb_planar;
+    auto handle{Nauty().spawn(
+        [&nb_planar](const Graph& G) {
+            if(G.is_planar())
+                ++nb_planar;
+        },
+        params
+    )};
+    while(not handle.poll()) {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        const auto snapshot{statistics.snapshot()};
+        double waiting{0};
+        for(const auto& worker : snapshot.workers)
+            waiting += worker.waiting;
+        std::cout << snapshot.produced() << " graphs produced, "
+                  << snapshot.consumed() << " processed, "
+                  << "workers waited " << waiting << "s in total" << std::endl;
+    }
+    handle.get();
+    std::cout << nb_planar.get() << " planar graphs" << std::endl;
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <iostream>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Record the timeline of a run in trace.json, to be opened with
+// chrome://tracing or https://ui.perfetto.dev
+int main() {
+    PipelineTrace trace("trace.json");
+    NautyParameters params{
+        .connected=true,
+        .V=9,
+        .Vmax=9,
+        .nb_producers=2,
+        .trace=&trace
+    };
+    reducers::Counter<> nb_planar;
+    Nauty().run_async(
+        [&nb_planar](const Graph& G) {
+            if(G.is_planar())
+                ++nb_planar;
+        },
+        params
+    );
+    std::cout << nb_planar.get() << " planar graphs, timeline written to trace.json" << std::endl;
+    return 0;
+}
@@ -0,0 +1,27 @@
+#include <iostream>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+// Count the connected graphs on 8 vertices whose complement is connected too,
+// with single-word kernels: every row of a graph on 8 vertices is one setword
+int main() {
+    static_assert(SmallGraph<8>::make_cycle(5).complement().E() == 5);
+    NautyParameters params{
+        .connected=true,
+        .V=8,
+        .Vmax=8
+    };
+    reducers::Counter<> count;
+    Nauty().run_inline(
+        [&count](GraphView view) {
+            if(SmallGraph<8>(view).complement().is_connected())
+                ++count;
+        },
+        params
+    );
+    std::cout << count.get() << " graphs on 8 vertices are connected "
+              << "and have a connected complement" << std::endl;
+    return 0;
+}
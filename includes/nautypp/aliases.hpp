@@ -15,7 +15,12 @@ typedef graph nauty_graph_t;
 typedef xword Vertex;
 static constexpr auto NO_VERTEX{std::numeric_limits<Vertex>::max()};
 
+/// Assumed size of a cache line, used to keep independently written data apart.
+static constexpr size_t CACHE_LINE_SIZE{64};
+
 class Graph;
+class GraphBatch;
+class GraphView;
 
 /* ******************** Concepts ******************** */
 template <typename T>
@@ -29,6 +34,18 @@ concept GraphConstRefFunctionType = requires(T obj, const Graph& G) {
 template <typename T>
 concept GraphFunctionType = GraphRefFunctionType<T>
                          or GraphConstRefFunctionType<T>;
+template <typename T>
+concept GraphBatchFunctionType = requires(T obj, GraphBatch& batch) {
+    { obj(batch) };
+} and not GraphFunctionType<T>;
+template <typename T>
+concept GraphViewFunctionType = requires(T obj, const GraphView& G) {
+    { obj(G) };
+} and not GraphFunctionType<T> and not GraphBatchFunctionType<T>;
+template <typename T>
+concept NautyCallbackType = GraphFunctionType<T>
+                         or GraphBatchFunctionType<T>
+                         or GraphViewFunctionType<T>;
 
 }
 #endif
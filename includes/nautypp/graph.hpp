@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <span>
 
 #include "nauty/planarity.h"
 
@@ -12,6 +13,14 @@
 #include <nautypp/cliquer.hpp>
 #include <nautypp/iterators.hpp>
 #include <nautypp/properties.hpp>
+#include <nautypp/view.hpp>
+
+/// Graphs with at most that many vertices store their rows inside the Graph
+/// object instead of allocating them (similar to SSO). 0 disables it.
+/// Must be the same for the library and the code using it.
+#ifndef NAUTYPP_SMALL_GRAPH_SIZE
+# define NAUTYPP_SMALL_GRAPH_SIZE 16
+#endif
 
 namespace nautypp {
 /// \brief Wrapper of nauty's graphs
@@ -66,6 +75,13 @@ public:
         return Graph(g, n, true);
     }
 
+    /// \brief Get a read-only view over the rows of the graph.
+    ///
+    /// The view is only valid as long as the graph is neither modified nor destroyed.
+    inline GraphView view() const {
+        return GraphView(g, n);
+    }
+
     /// \brief Construct the complement of the graph.
     /// \return The complement of this.
     Graph complement() const;
@@ -86,7 +102,13 @@ public:
     /// \brief Number of edges of the graph
     /// \return The (non-negative) number of edges of the graph
     inline size_t E() const {
-        return non_const_self().nb_edges.get();
+        return non_const_self()._properties.nb_edges(view());
+    }
+
+    /// \brief Determine whether the rows are stored inside the object (see
+    /// NAUTYPP_SMALL_GRAPH_SIZE) rather than on the heap or in a buffer.
+    inline bool is_inline() const {
+        return g == _small_rows;
     }
 
 
@@ -121,7 +143,7 @@ public:
     }
 
     inline explicit operator cliquer_graph_t*() const {
-        return non_const_self()._as_cliquer.get();
+        return non_const_self()._properties.cliquer(view());
     }
 
     /// \brief Get the degree of a vertex.
@@ -132,13 +154,11 @@ public:
     /// **Example**:
     /// \include degree/degrees.cpp
     inline size_t degree(Vertex v) const {
-        if(degrees.size() < V())
-            non_const_self().init_degrees();
 #ifdef NAUTYPP_DEBUG
-        return non_const_self().degrees.at(v).get();
-#else
-        return non_const_self().degrees[v].get();
+        if(v >= V())
+            throw std::out_of_range("No such vertex");
 #endif
+        return non_const_self()._properties.degree(view(), v);
     }
 
     /// \brief Get the degree of every vertex.
@@ -148,10 +168,17 @@ public:
     /// **Example**:
     /// \include degree/degrees.cpp
     inline std::vector<size_t> degree() const {
-        std::vector<size_t> ret(V());
-        for(Vertex v{0}; v < V(); ++v)
-            ret[v] = degree(v);
-        return ret;
+        return view().degree();
+    }
+
+    /// \brief Write the degree of every vertex into a given array.
+    ///
+    /// The degrees are computed in one pass over the rows by a vectorised
+    /// kernel (see kernels::degrees()), and nothing is allocated.
+    ///
+    /// \param degrees Room for V() degrees: `degrees[v]` is set to the degree of `v`.
+    inline void degree(std::span<size_t> degrees) const {
+        view().degree(degrees);
     }
 
     /// \brief Get the minimum degree of the graph
@@ -161,8 +188,7 @@ public:
     /// **Example**:
     /// \include degree/degrees.cpp
     inline size_t delta() const {
-        auto degrees{degree()};
-        return *std::min_element(degrees.cbegin(), degrees.cend());
+        return delta_Delta().first;
     }
 
     /// Alias of delta()
@@ -175,8 +201,7 @@ public:
     /// **Example**:
     /// \include degree/degrees.cpp
     inline size_t Delta() const {
-        auto degrees{degree()};
-        return *std::max_element(degrees.cbegin(), degrees.cend());
+        return delta_Delta().second;
     }
 
     /// Alias of Delta()
@@ -184,18 +209,14 @@ public:
 
     /// \brief Get both the minimum and the maximum degree of the graph.
     ///
-    /// See delta() and Delta()
-    /// \return A pair `{delta, Delta}`
+    /// See delta() and Delta(). Both are found in one pass over the rows,
+    /// without allocating.
+    /// \return A pair `{delta, Delta}` (`{0, 0}` for the empty graph)
     ///
     /// **Example**:
     /// \include degree/degrees.cpp
-    inline std::pair<size_t, size_t> delta_Delta() {
-        auto degrees{degree()};
-        auto [min_it, max_it] = std::minmax_element(
-            degrees.cbegin(),
-            degrees.cend()
-        );
-        return {*min_it, *max_it};
+    inline std::pair<size_t, size_t> delta_Delta() const {
+        return view().delta_Delta();
     }
 
     /// \brief Alias for the degree distribution of a graph.
@@ -212,17 +233,17 @@ public:
     /// **Example**:
     /// \include degree/degrees.cpp
     inline DegreeDistribution degree_distribution() const {
-        std::vector<size_t> counts(V(), 0);
-        for(Vertex v{0}; v < V(); ++v)
-            ++counts[degree(v)];
-        std::vector<std::pair<size_t, size_t>> ret;
-        for(size_t d{0}; d < V(); ++d) {
-            auto count{counts[d]};
-            if(count == 0)
-                continue;
-            ret.emplace_back(d, count);
-        }
-        return ret;
+        return view().degree_distribution();
+    }
+
+    /// \brief Write the number of vertices of every degree into a given array.
+    ///
+    /// Computed in one pass over the rows, without allocating.
+    ///
+    /// \param counts Room for V() values: `counts[d]` is set to the number of
+    /// vertices of degree `d`.
+    inline void degree_distribution(std::span<size_t> counts) const {
+        view().degree_distribution(counts);
     }
 
     /// \brief Determine if two vertices are linked by an edge
@@ -243,14 +264,15 @@ public:
 
     /// \brief Add an edge between to vertices
     ///
+    /// The cached degrees and number of edges are updated in constant time.
+    ///
     /// \param v,w Vertices to join by an edge
     inline void link(Vertex v, Vertex w) {
+        if(are_linked(v, w))
+            return;
         ADDELEMENT(GRAPHROW(g, v, _m), w);
         ADDELEMENT(GRAPHROW(g, w, _m), v);
-        degrees[v].set_stale();
-        degrees[w].set_stale();
-        nb_edges.set_stale();
-        _as_cliquer.set_stale();
+        _properties.edge_added(v, w);
     }
 
     /// Alias of link()
@@ -258,6 +280,24 @@ public:
         return link(v, w);
     }
 
+    /// \brief Remove the edge between two vertices (if any)
+    ///
+    /// The cached degrees and number of edges are updated in constant time.
+    ///
+    /// \param v,w Vertices whose edge is removed
+    inline void unlink(Vertex v, Vertex w) {
+        if(not are_linked(v, w))
+            return;
+        DELELEMENT(GRAPHROW(g, v, _m), w);
+        DELELEMENT(GRAPHROW(g, w, _m), v);
+        _properties.edge_removed(v, w);
+    }
+
+    /// Alias of unlink()
+    inline void remove_edge(Vertex v, Vertex w) {
+        return unlink(v, w);
+    }
+
     /// \brief Get all the neighbours of a vertex
     ///
     /// \param v The vertex whose neighbours are demanded
@@ -356,16 +396,12 @@ public:
     ///
     /// \param v The vertex to isolate.
     inline void isolate_vertex(Vertex v) {
-        setword i;
         setword* Nv{setwordof(v)};
-        while((i = FIRSTBIT(*Nv)) != WORDSIZE) {
+        for(int i{-1}; (i = nextelement(Nv, static_cast<int>(_m), i)) >= 0;) {
             DELELEMENT(setwordof(i), static_cast<setword>(v));
-            DELELEMENT(Nv, i);
-            degrees[i].set_stale();
+            _properties.edge_removed(v, static_cast<Vertex>(i));
         }
-        degrees[v].set_stale();
-        nb_edges.set_stale();
-        _as_cliquer.set_stale();
+        std::fill_n(Nv, _m, setword{0});
     }
 
     /// \brief Create a new graph corresponding to the vertex-disjoint union with another graph.
@@ -392,6 +428,52 @@ public:
         return ConnectedComponents(*this);
     }
 
+    // Small cliques
+
+    /// \brief Count the cliques on \a k vertices of the graph.
+    ///
+    /// The cliques are enumerated by intersecting rows (a bitwise AND per
+    /// setword) and the last vertex is counted with a popcount, so nothing is
+    /// allocated per vertex. Suited to small \a k: see apply_to_cliques() and
+    /// cliquer for larger cliques. See kernels::count_cliques().
+    ///
+    /// \param k The number of vertices of the cliques (e.g. 3 for triangles).
+    /// \return The number of subgraphs isomorphic to \f$K_k\f$.
+    inline size_t nb_cliques(size_t k) const {
+        return view().nb_cliques(k);
+    }
+
+    /// \brief Count the triangles of the graph.
+    ///
+    /// See nb_cliques()
+    inline size_t nb_triangles() const {
+        return view().nb_triangles();
+    }
+
+    /// \brief Count the \f$K_4\f$ subgraphs of the graph.
+    ///
+    /// See nb_cliques()
+    inline size_t nb_K4() const {
+        return view().nb_K4();
+    }
+
+    /// \brief Determine whether the graph contains a clique on \a k vertices.
+    ///
+    /// Same as `nb_cliques(k) > 0`, but the search stops at the first clique.
+    inline bool has_clique(size_t k) const {
+        return view().has_clique(k);
+    }
+
+    /// \brief Determine whether the graph contains a triangle.
+    ///
+    /// See has_clique()
+    ///
+    /// **Example**:
+    /// \include multithreaded/count_triangle_free_graphs.cpp
+    inline bool has_triangle() const {
+        return view().has_triangle();
+    }
+
     // Cliquer
 
     /// \brief Find some clique in the graph
@@ -491,44 +573,7 @@ public:
     /// **Example**:
     /// \include planar.cpp
     inline bool is_planar() const {
-        const auto n{this->V()};
-        // see nauty::planarg.c::isplanar
-        DYNALLSTAT(t_ver_sparse_rep,  V, V_sz);
-        DYNALLSTAT(t_adjl_sparse_rep, A, A_sz);
-        DYNALLOC1(t_ver_sparse_rep,   V, V_sz, n,       "is_planar");
-        DYNALLOC1(t_adjl_sparse_rep,  A, A_sz, 2*E()+1, "is_planar");
-        t_dlcl **dfs_tree, **back_edges, **mult_edges;
-        t_ver_edge *embed_graph;
-        int edge_pos, v, w, c;
-        // Conversion to nauty::planarity adjl format
-        int k{0};
-        for(Vertex v{0}; v < n; ++v) {
-            if(degree(v) == 0) {
-                V[v].first_edge = NIL;
-            } else {
-                V[v].first_edge = k;
-                for(Vertex w : neighbours_of(v)) {
-                    A[k].end_vertex = w;
-                    A[k].next = k+1;
-                    ++k;
-                    // No need to handle loop
-                }
-                A[k-1].next = NIL;
-            }
-        }
-        // see nauty::planarity.c
-        bool ret{static_cast<bool>(sparseg_adjl_is_planar(
-            V, n, A, &c,
-            &dfs_tree, &back_edges, &mult_edges,
-            &embed_graph, &edge_pos, &v, &w
-        ))};
-        sparseg_dlcl_delete(dfs_tree, n);
-        sparseg_dlcl_delete(back_edges, n);
-        sparseg_dlcl_delete(mult_edges, n);
-        embedg_VES_delete(embed_graph, n);
-        DYNFREE(V, V_sz);
-        DYNFREE(A, A_sz);
-        return ret;
+        return GraphView::planar(*this);
     }
 
     /// See is_planar
@@ -538,9 +583,12 @@ public:
 
     friend class EdgeIterator;
     friend class AllEdgeIterator;
+    friend class BaseNautyWorker;
+    friend class NautyConsumer;
+    friend class GraphBatch;
+    friend class GraphGenerator;
+    friend class Nauty;
     friend class NautyContainer;
-    friend class EdgeProperty;
-    friend class DegreeProperty;
 
 /* ******************** Static Methods ******************** */
 
@@ -662,17 +710,19 @@ public:
         return ret;
     }
 private:
+    static constexpr size_t SMALL_GRAPH_WORDS{
+        NAUTYPP_SMALL_GRAPH_SIZE == 0
+        ? 1
+        : NAUTYPP_SMALL_GRAPH_SIZE * SETWORDSNEEDED(NAUTYPP_SMALL_GRAPH_SIZE)
+    };
+
     size_t n;
-    bool host;
-#ifdef NAUTYPP_SGO
-    graph __small_graph_buffer[NAUTYPP_SMALL_GRAPH_SIZE];
-#endif
+    bool host;  // whether g was allocated on the heap by this graph
     size_t _m{1};
     graph* g;
+    graph _small_rows[SMALL_GRAPH_WORDS];  // rows of the graphs of order <= NAUTYPP_SMALL_GRAPH_SIZE
 
-    EdgeProperty nb_edges;
-    std::vector<DegreeProperty> degrees;
-    _CliquerGraphProperty _as_cliquer;
+    PropertyCache _properties;
 
     inline void reset() {
         if(not host or g == nullptr)
@@ -682,26 +732,43 @@ private:
         host = false;
     }
 
-    inline void assign_from(const graph* G, size_t V) {
-#ifdef NAUTYPP_SGO
+    /* make g point to room for the rows of a graph on V vertices */
+    inline void allocate(size_t V) {
+        _m = SETWORDSNEEDED(V);
         if(V <= NAUTYPP_SMALL_GRAPH_SIZE) {
-            g = __small_graph_buffer;
+            g = _small_rows;
             host = false;
         } else {
             g = new graph[_m*V];
             host = true;
-        };
-#else
-        g = new graph[_m*V];
-        host = true;
-#endif
+        }
+    }
+
+    inline void assign_from(const graph* G, size_t V) {
+        allocate(V);
         memcpy(g, G, _m*V*sizeof(*G));
     }
 
-    inline void init_degrees() {
-        degrees.reserve(n);
-        for(size_t v{degrees.size()}; v < V(); ++v)
-            degrees.emplace_back(*this, v);
+    /* take the rows of G (moved from), which must then be left empty */
+    void steal_rows(Graph& G);
+
+    /* empty graph that does not own its rows, see rebind() */
+    static inline Graph make_view() {
+        return Graph(static_cast<graph*>(nullptr), 0, false);
+    }
+
+    /* whether the rows belong to someone else (a buffer of nautypp) */
+    inline bool is_view() const {
+        return not host and g != nullptr and not is_inline();
+    }
+
+    /* make a view point to other rows without reallocating anything:
+     * only the cached properties are invalidated */
+    inline void rebind(graph* G, size_t V) {
+        n = V;
+        _m = SETWORDSNEEDED(V);
+        g = G;
+        _properties.invalidate();
     }
 
     inline size_t __get_m() const {
@@ -737,6 +804,10 @@ private:
         return GRAPHROW(g, v, _m);
     }
 };
+
+inline Graph GraphView::copy() const {
+    return Graph(_rows, _n);
+}
 }
 
 #endif
@@ -1,37 +1,12 @@
 #ifndef NAUTYPP_IMPL_HPP
 #define NAUTYPP_IMPL_HPP
 
-#include <bit>
-
 #include <nautypp/algorithms.hpp>
 #include <nautypp/graph.hpp>
 #include <nautypp/iterators.hpp>
 #include <nautypp/properties.hpp>
 
 namespace nautypp {
-void DegreeProperty::compute() {
-    const auto m{graph->__get_m()};
-    auto gv{GRAPHROW(static_cast<const nauty_graph_t*>(*graph), v, m)};
-    value = 0;
-    for(size_t i{0}; i < m; ++i, ++gv)
-        value += std::popcount(*gv);
-}
-
-void EdgeProperty::compute() {
-    value = 0;
-    for(size_t v{0}; v < graph->V(); ++v)
-        value += graph->degree(v);
-    value >>= 1;  // sum(d(v)) == 2E
-}
-
-void _CliquerGraphProperty::compute() {
-    clear();
-    value = graph_new(graph->V());
-    for(auto [v, w] : graph->edges()) {
-        GRAPH_ADD_EDGE(value, v, w);
-    }
-}
-
 ConnectedComponents::ConnectedComponents(const Graph& graph):
         G{graph}, ids(graph.V(), UNVISITED), nb_components{0} {
     _run();
@@ -0,0 +1,88 @@
+#ifndef NAUTYPP_KERNELS_HPP
+#define NAUTYPP_KERNELS_HPP
+
+/// \file kernels.hpp
+/// \brief Vectorised kernels over packed adjacency rows (in the nauty format).
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+
+#include <nauty/nauty.h>
+
+#include <nautypp/aliases.hpp>
+
+namespace nautypp {
+
+/// \brief Kernels processing whole adjacency matrices at once.
+///
+/// The instruction set is chosen at runtime, once, among the ones supported
+/// by the CPU: AVX-512 (with VPOPCNTDQ), AVX2, or a portable scalar fallback.
+/// Vector kernels are only compiled on x86-64 with GCC or Clang, if
+/// `WORDSIZE == 64`, and unless NAUTYPP_NO_SIMD is defined when building
+/// the library.
+namespace kernels {
+
+/// \brief Instruction sets the kernels are implemented with.
+enum class Backend {
+    SCALAR,
+    AVX2,
+    AVX512
+};
+
+/// \brief Number of vertices whose degrees are computed at once by
+/// for_each_degree_chunk().
+static constexpr size_t DEGREE_CHUNK{256};
+
+/// \brief Backend used by the kernels (the fastest one supported by the CPU).
+Backend backend();
+
+/// \brief Determine whether the CPU (and the build) supports \a backend.
+bool supported(Backend backend);
+
+/// \brief Name of a backend (`"scalar"`, `"avx2"` or `"avx512"`).
+const char* name(Backend backend);
+
+/// \brief Write the degree of each of the \a n vertices of a graph into \a out.
+///
+/// \param rows The rows of the graph, \a m setwords per row.
+/// \param out Room for \a n degrees.
+void degrees(const graph* rows, size_t n, size_t m, size_t* out);
+
+/// \brief Same as degrees(), with a given (supported) backend.
+void degrees(Backend backend, const graph* rows, size_t n, size_t m, size_t* out);
+
+/// \brief Number of bits set among \a nb_words setwords.
+size_t popcount(const setword* words, size_t nb_words);
+
+/// \brief Count the cliques on \a k vertices (the \f$K_k\f$ subgraphs) of a graph.
+///
+/// The cliques are enumerated in increasing order of their vertices: the
+/// candidates to extend a clique are the intersection (a row AND) of the
+/// rows of its vertices, and the last vertex is counted with a popcount.
+/// Nothing is allocated if `k*m <= 256`.
+///
+/// \param rows The rows of the graph, \a m setwords per row.
+/// \param limit Stop counting once \a limit cliques are found (e.g. 1 to
+/// determine whether there is a \f$K_k\f$).
+/// \return The number of cliques, or \a limit if there are at least as many.
+size_t count_cliques(const graph* rows, size_t n, size_t m, size_t k,
+        size_t limit=std::numeric_limits<size_t>::max());
+
+/// \brief Call `f(first, degrees, k)` on consecutive chunks of the degree sequence
+/// of a graph, where `degrees[i]` is the degree of the vertex `first+i`, for
+/// `i < k`. Nothing is allocated.
+template <typename Function>
+inline void for_each_degree_chunk(const graph* rows, size_t n, size_t m, Function&& f) {
+    size_t chunk[DEGREE_CHUNK];
+    for(size_t first{0}; first < n; first += DEGREE_CHUNK) {
+        const auto k{std::min(DEGREE_CHUNK, n-first)};
+        degrees(rows + first*m, k, m, chunk);
+        f(first, static_cast<const size_t*>(chunk), k);
+    }
+}
+
+}  // namespace kernels
+}  // namespace nautypp
+
+#endif
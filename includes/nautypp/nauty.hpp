@@ -6,11 +6,28 @@
 /// \brief Wrapper for nauty's geng and gentreeg in C++
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
 #include <thread>
+#include <tuple>
+#include <type_traits>
 #include <vector>
 
 #ifdef __linux__
@@ -27,7 +44,15 @@
 #include <nautypp/cliquer.hpp>
 #include <nautypp/graph.hpp>
 #include <nautypp/iterators.hpp>
+#include <nautypp/kernels.hpp>
+#include <nautypp/placement.hpp>
 #include <nautypp/properties.hpp>
+#include <nautypp/reducers.hpp>
+#include <nautypp/serialization.hpp>
+#include <nautypp/small_graph.hpp>
+#include <nautypp/statistics.hpp>
+#include <nautypp/trace.hpp>
+#include <nautypp/view.hpp>
 
 namespace nautypp {
 namespace version {
@@ -44,14 +69,6 @@ static inline const char* get_version() {
 }
 }
 
-#ifdef NAUTYPP_SGO
-# ifndef NAUTYPP_SMALL_GRAPH_SIZE
-// graphs with less than that many vertices do not need to be dynamically
-// allocated (similar to SSO)
-#  define NAUTYPP_SMALL_GRAPH_SIZE 0
-# endif
-#endif
-
 extern int _geng_main(int, char**);
 extern int _gentreeg_main(int, char**);
 
@@ -70,6 +87,14 @@ static inline void rename_thread(std::thread& thread, const char* name) {
 /// \namespace nautypp
 /// \brief Namespace containing everything related to the wrapper
 namespace nautypp {
+/// \brief Predicate deciding whether a graph must be cut off during the generation.
+///
+/// Called with a graph of the canonical augmentation search and the number
+/// of vertices of the graphs to generate. Returns true to discard the graph
+/// together with all the graphs it would be extended to.
+/// See NautyParameters::prune.
+typedef std::function<bool(const Graph& G, size_t final_order)> PruningPredicate;
+
 /// \struct NautyParameters
 /// \brief Wrapper for the parameters given to geng/gentreeg
 struct NautyParameters {
@@ -90,6 +115,104 @@ struct NautyParameters {
     int  Vmax          = -1;  ///< maximum number of vertices
     int  min_deg       = -1;  ///< minimum degree of vertices
     int  max_deg       = std::numeric_limits<int>::max();  ///< maximum degree of vertices
+
+    /// Number of geng/gentreeg instances running concurrently, each of them
+    /// generating a disjoint class `res/mod` of the graphs (requires nauty
+    /// to be configured with `--enable-tls`). Capped by the number of workers.
+    unsigned nb_producers = 1;
+
+    /// Only generate the class `shard_index/shard_count` of the graphs, so that
+    /// independent processes (or hosts) can split an enumeration between them.
+    /// See Nauty::run_shard().
+    unsigned shard_index  = 0;
+    unsigned shard_count  = 1;  ///< See shard_index.
+
+    /// Cut off the graphs (and their descendants) for which this predicate
+    /// holds, while geng builds them vertex by vertex (geng's `PRUNE` hook).
+    /// It is called on the graphs of every order up to the final one, so it
+    /// must describe a hereditary property (e.g. containing some forbidden
+    /// induced subgraph) for no valid graph to be lost.
+    /// Every producer calls its own copy of the predicate, so stateful
+    /// predicates need no synchronisation.
+    /// Shards of a same enumeration must all be run with the same predicate.
+    /// Only supported by geng (i.e. not with `tree`).
+    PruningPredicate prune{};
+
+    /// Same as prune, but called before geng's canonicity test (geng's
+    /// `PREPRUNE` hook): it is called on more graphs, and should therefore
+    /// only be used for cheap tests.
+    PruningPredicate preprune{};
+
+    /// If not null, the producers and workers of the run record their
+    /// activity in it (see PipelineStatistics). It must outlive the run.
+    /// Not used by Nauty::generate().
+    PipelineStatistics* statistics = nullptr;
+
+    /// If not null, the producers and workers of the run record their
+    /// timeline in it (see PipelineTrace). It must outlive the run.
+    /// Not used by Nauty::generate().
+    PipelineTrace* trace = nullptr;
+
+    /// CPUs of the producers and workers of the run (not pinned by default).
+    ThreadPlacement placement{};
+};
+
+/// \brief Header of the files written by Nauty::run_shard().
+///
+/// Identifies the shard and the enumeration it belongs to, so that shards
+/// of different enumerations cannot be merged together by mistake.
+struct ShardHeader {
+    static constexpr std::array<char, 8> MAGIC{'n', 'a', 'u', 't', 'y', 'p', 'p', 'S'};
+    static constexpr std::uint32_t VERSION{1};
+
+    /// Generation parameters (everything that changes the set of graphs).
+    typedef std::array<std::int32_t, 16> Fingerprint;
+
+    unsigned    shard_index;
+    unsigned    shard_count;
+    Fingerprint fingerprint;
+
+    ShardHeader(const NautyParameters& parameters):
+            shard_index{parameters.shard_index},
+            shard_count{parameters.shard_count},
+            fingerprint{
+                parameters.tree,    parameters.connected, parameters.biconnected,
+                parameters.triangle_free, parameters.C4_free, parameters.C5_free,
+                parameters.K4_free, parameters.chordal,   parameters.split,
+                parameters.perfect, parameters.claw_free, parameters.bipartite,
+                parameters.V, parameters.Vmax, parameters.min_deg, parameters.max_deg
+            } {
+    }
+
+    inline bool same_enumeration_as(const ShardHeader& other) const {
+        return shard_count == other.shard_count
+            and fingerprint == other.fingerprint;
+    }
+
+    inline void write(std::ostream& os) const {
+        os.write(MAGIC.data(), MAGIC.size());
+        serialization::write(os, VERSION);
+        serialization::write(os, static_cast<std::uint32_t>(shard_index));
+        serialization::write(os, static_cast<std::uint32_t>(shard_count));
+        serialization::write(os, fingerprint);
+    }
+
+    static inline ShardHeader read(std::istream& is) {
+        std::array<char, MAGIC.size()> magic;
+        if(not is.read(magic.data(), magic.size()) or magic != MAGIC)
+            throw std::runtime_error("Not a nautypp shard file");
+        if(serialization::read<std::uint32_t>(is) != VERSION)
+            throw std::runtime_error("Unsupported shard file version");
+        ShardHeader ret;
+        ret.shard_index = serialization::read<std::uint32_t>(is);
+        ret.shard_count = serialization::read<std::uint32_t>(is);
+        ret.fingerprint = serialization::read<Fingerprint>(is);
+        if(ret.shard_index >= ret.shard_count)
+            throw std::runtime_error("Corrupted shard file header");
+        return ret;
+    }
+private:
+    ShardHeader() = default;
 };
 
 
@@ -103,204 +226,1111 @@ enum class NautyStatus {
     END_OF_THREAD    ///< Buffer is deactivated.
 };
 
+/// \brief Value a callback can return to end the run early.
+///
+/// Callbacks returning `void` never stop the run. See Nauty::run_async().
+enum class CallbackStatus {
+    CONTINUE,  ///< Keep on processing graphs.
+    STOP       ///< Stop the producers and discard the pending graphs.
+};
+
 // forward declarations
 class Nauty;
 template <GraphFunctionType Callback>
 class NautyWorker;
 
+/*      *************** Synchronisation ***************      */
+
+/// Number of busy-wait iterations before a thread parks itself.
+static constexpr unsigned SPIN_LIMIT{512};
+
+/// \brief Hint the CPU that the calling thread is busy-waiting.
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+/// \brief Place where threads can sleep until another thread wakes them up.
+///
+/// Parking relies on `std::atomic::wait` (a futex on Linux) and waking up is
+/// free as long as nobody is parked, so the fast path never enters the kernel.
+class ParkingSpot {
+public:
+    ParkingSpot() = default;
+    ParkingSpot(const ParkingSpot&) = delete;
+    ParkingSpot& operator=(const ParkingSpot&) = delete;
+
+    /// \brief Sleep until \a ready returns true.
+    ///
+    /// \a ready is evaluated after announcing that the thread is parked,
+    /// so that a concurrent unpark() cannot be missed.
+    template <typename Predicate>
+    inline void park(Predicate&& ready) {
+        _nb_parked.fetch_add(1, std::memory_order_seq_cst);
+        while(true) {
+            auto epoch{_epoch.load(std::memory_order_seq_cst)};
+            if(ready())
+                break;
+            _epoch.wait(epoch, std::memory_order_seq_cst);
+        }
+        _nb_parked.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /// \brief Wake up every parked thread (if any).
+    inline void unpark() {
+        if(_nb_parked.load(std::memory_order_seq_cst) > 0) {
+            _epoch.fetch_add(1, std::memory_order_seq_cst);
+            _epoch.notify_all();
+        }
+    }
+private:
+    std::atomic<std::uint32_t> _epoch{0};
+    std::atomic<std::uint32_t> _nb_parked{0};
+};
+
 /*      *************** Containers ***************      */
 
-/// \brief Communication buffer between producer and consumer threads.
+/// \brief Slabs of rows of the destroyed buffers, kept for the next buffers.
+///
+/// A NautyContainerBuffer gives its slab back when it is destroyed, and a
+/// new buffer takes the smallest kept slab large enough for it (and at most
+/// twice as large). Consecutive runs (e.g. the shards of an enumeration, or
+/// runs started in a loop) thus write their graphs into memory which is
+/// already mapped (and possibly still cached) instead of allocating and
+/// faulting in new slabs every time.
 ///
-/// The buffer is separated into a *read* buffer and a *write* buffer.
-/// The consumer thread pops from the former, while the producer thread inserts in the latter.
-/// When the read buffer is empty, the consumer will swap the two buffers.
-template <typename T>
-class ContainerBuffer {
+/// At most limit() bytes are kept: the slabs given back beyond that are freed.
+class SlabPool {
 public:
-    ContainerBuffer() = delete;
-    ContainerBuffer(size_t maxsize):
-            _size{maxsize},
-            _read_buffer(), _write_buffer(),
-            _writable{true}, _should_swap{false} {
-        _read_buffer.reserve(maxsize);
-        _write_buffer.reserve(maxsize);
+    typedef std::unique_ptr<graph[]> Slab;
+
+    /// Default value of limit() (in bytes).
+    static constexpr size_t DEFAULT_LIMIT{size_t{64} << 20};
+
+    SlabPool() = default;
+    SlabPool(const SlabPool&) = delete;
+
+    /// \brief Pool shared by every buffer of the process.
+    static inline SlabPool& instance() {
+        static SlabPool pool;
+        return pool;
+    }
+
+    /// \brief Get a slab of at least \a size setwords.
+    ///
+    /// \param capacity Set to the number of setwords of the slab.
+    /// \param reuse Whether a kept slab may be returned. Otherwise, the slab is
+    /// always allocated (e.g. to be first written by the calling thread).
+    inline Slab take(size_t size, size_t& capacity, bool reuse=true) {
+        if(reuse) {
+            std::lock_guard lock(_mutex);
+            auto best{_slabs.end()};
+            for(auto it{_slabs.begin()}; it != _slabs.end(); ++it)
+                if(it->size >= size and it->size / 2 <= size
+                        and (best == _slabs.end() or it->size < best->size))
+                    best = it;
+            if(best != _slabs.end()) {
+                capacity = best->size;
+                auto ret{std::move(best->slab)};
+                _slabs.erase(best);
+                _bytes -= capacity * sizeof(graph);
+                ++_nb_reused;
+                return ret;
+            }
+        }
+        capacity = size;
+        return Slab(new graph[size]);
+    }
+
+    /// \brief Keep a slab of \a capacity setwords for the next buffers (or
+    /// free it if the pool would exceed its limit).
+    inline void give(Slab slab, size_t capacity) {
+        std::lock_guard lock(_mutex);
+        if(_bytes + capacity * sizeof(graph) > _limit)
+            return;
+        _bytes += capacity * sizeof(graph);
+        _slabs.push_back({std::move(slab), capacity});
+    }
+
+    /// \brief Maximal number of bytes kept.
+    inline size_t limit() const {
+        std::lock_guard lock(_mutex);
+        return _limit;
+    }
+
+    /// \brief Set the maximal number of bytes kept (0 disables the recycling).
+    ///
+    /// The oldest slabs are freed until the pool fits.
+    inline void set_limit(size_t bytes) {
+        std::lock_guard lock(_mutex);
+        _limit = bytes;
+        while(_bytes > _limit) {
+            _bytes -= _slabs.front().size * sizeof(graph);
+            _slabs.erase(_slabs.begin());
+        }
     }
 
-    ContainerBuffer(const ContainerBuffer&) = delete;
-    ContainerBuffer(ContainerBuffer&&) noexcept = default;
+    /// \brief Number of bytes currently kept.
+    inline size_t size() const {
+        std::lock_guard lock(_mutex);
+        return _bytes;
+    }
+
+    /// \brief Number of slabs handed out again since the creation of the pool.
+    inline size_t nb_reused() const {
+        std::lock_guard lock(_mutex);
+        return _nb_reused;
+    }
 
-    ~ContainerBuffer() {
-        if(_read_buffer.size() > 0)
-            std::cerr << "Destroying a buffer w/ reading capability";
-        if(_write_buffer.size() > 0)
-            std::cerr << "Missed a swap (" << _write_buffer.size() << ")\n";
+    /// \brief Free every kept slab.
+    inline void clear() {
+        std::lock_guard lock(_mutex);
+        _slabs.clear();
+        _bytes = 0;
     }
+private:
+    struct Entry {
+        Slab   slab;
+        size_t size;  // number of setwords
+    };
 
-    /// \brief Tries to move something into the write buffer.
+    mutable std::mutex  _mutex;
+    std::vector<Entry>  _slabs;
+    size_t              _bytes{0};
+    size_t              _limit{DEFAULT_LIMIT};
+    size_t              _nb_reused{0};
+};
+
+/// \brief Communication buffer of graphs between producer and consumer threads.
+///
+/// Bounded lock-free single-producer/multi-consumer ring buffer.
+/// Each buffer belongs to one worker (its *owner*) which consumes graphs one
+/// at a time, but idle workers can steal batches of graphs from it.
+///
+/// The buffer owns a slab of packed adjacency rows, allocated once, where
+/// every slot has room for a graph of the maximal order of the run: the
+/// producer copies the rows of a graph into a free slot, and consumers read
+/// them in place and only release the slot when they are done with it.
+/// Hence no memory is allocated (nor freed) per graph, and the producer and
+/// the consumers keep working on the same slab for the whole run. The slab
+/// is then given back to the SlabPool for the buffers of the next runs.
+///
+/// Every slot carries a sequence number telling whether it is ready to be
+/// consumed or free to be written, so that the producer never overwrites a
+/// slot a consumer is still reading.
+/// The producer and consumer indices live on distinct cache lines.
+/// An owner finding its buffer empty spins for a short while and then parks
+/// until the producer pushes something or disables the buffer.
+/// A producer finding every buffer full parks on the ParkingSpot shared by
+/// all the buffers it feeds.
+class NautyContainerBuffer {
+public:
+    NautyContainerBuffer() = delete;
+
+    /// \param maxsize The number of graphs the buffer can hold.
+    /// \param max_order The largest number of vertices of a graph pushed in the buffer.
+    /// \param producer The parking spot of the producer feeding the buffer.
+    /// \param reuse_slab Whether the slab may be taken from the SlabPool
+    /// (otherwise, it is allocated: see prefault()).
+    NautyContainerBuffer(size_t maxsize, size_t max_order,
+            std::shared_ptr<ParkingSpot> producer, bool reuse_slab=true):
+            // sequence numbers of a full and of an empty slot only differ if capacity > 1
+            _capacity{std::bit_ceil(std::max<size_t>(maxsize, 2))},
+            _mask{_capacity-1},
+            _max_order{std::max<size_t>(max_order, 1)},
+            _stride{SETWORDSNEEDED(_max_order) * _max_order},
+            _slots{new Slot[_capacity]},
+            _rows{SlabPool::instance().take(_capacity * _stride, _slab_size, reuse_slab)},
+            _producer{std::move(producer)} {
+        for(size_t i{0}; i < _capacity; ++i)
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    NautyContainerBuffer(const NautyContainerBuffer&) = delete;
+    NautyContainerBuffer(NautyContainerBuffer&&) = delete;
+
+    ~NautyContainerBuffer() {
+        size_t nb_unread{0};
+        for(auto i{_head.load(std::memory_order_relaxed)};
+                i != _tail.load(std::memory_order_relaxed); ++i)
+            if(ready(i))
+                ++nb_unread;
+        if(nb_unread > 0)
+            std::cerr << "Destroying a buffer with " << nb_unread << " unread elements\n";
+        SlabPool::instance().give(std::move(_rows), _slab_size);
+    }
+
+    /// \brief Tries to write a graph into the buffer.
     ///
     /// The insertion can only succeed if the buffer is not full.
-    /// **Be careful**: if the insertion succeeds, the object is *moved* and not *copied*!
-    /// \param G The element to insert.
-    /// \return true if the element was inserted.
-    inline bool push(T& G) {
-        if(_should_swap or write_size() == _size) {
-            _should_swap = true;
+    /// Must only be called by the producer thread.
+    /// \param n The number of vertices of the graph.
+    /// \param fill Function writing the `SETWORDSNEEDED(n)*n` rows of the
+    /// graph at the address it is given (only called if the insertion succeeds).
+    /// \return true if the graph was inserted.
+    template <typename Fill>
+    inline bool push(size_t n, Fill& fill) {
+#ifdef NAUTYPP_DEBUG
+        if(n > _max_order)
+            throw std::runtime_error("Graph too large for the buffer");
+#endif
+        const auto tail{_tail.load(std::memory_order_relaxed)};
+        auto& slot{_slots[tail & _mask]};
+        if(slot.sequence.load(std::memory_order_acquire) != tail)
             return false;
-        }
-        _write_buffer.push_back(std::move(G));
+        slot.order = n;
+        fill(rows_of(tail));
+        slot.sequence.store(tail+1, std::memory_order_release);
+        _tail.store(tail+1, std::memory_order_seq_cst);
+        _consumer.unpark();
         return true;
     }
 
-    class EmptyBuffer : public std::exception {
-    };
+    /// \brief Consume the oldest graph of the buffer without blocking.
+    ///
+    /// \param f Function called with the rows and the order of the graph.
+    /// The rows are only valid until \a f returns.
+    /// \return false if the buffer was empty.
+    template <typename Function>
+    inline bool consume_one(Function& f) {
+        size_t first;
+        if(claim(1, false, first) == 0)
+            return false;
+        consume(first, f);
+        return true;
+    }
+
+    /// \brief Consume up to \a max of the oldest graphs of the buffer.
+    ///
+    /// At most half of the (rounded up) content is taken, so that the owner
+    /// keeps something to work on. See consume_one().
+    /// \return The number of consumed graphs.
+    template <typename Function>
+    inline size_t steal(Function& f, size_t max) {
+        size_t first;
+        const auto n{claim(max, true, first)};
+        for(size_t i{0}; i < n; ++i)
+            consume(first+i, f);
+        return n;
+    }
 
-    /// \brief Extract an element from the read buffer.
+    /// \brief Take up to \a max of the oldest graphs of the buffer.
     ///
-    /// The buffers can be swapped if the read buffer is empty
-    /// and the write buffer is full.
-    /// \throws EmptyBuffer if both the read and write buffers are
-    /// empty, and the buffer is deactivated.
-    /// \return An element from the read buffer.
-    inline T pop() {
+    /// The graphs stay in their slots until release() is called: they can
+    /// be read in place through a GraphBatch.
+    /// \param max The maximal number of graphs to take.
+    /// \param steal Whether to only take half of the (rounded up) content.
+    /// \param first Set to the index of the first graph taken.
+    /// \return The number of graphs taken.
+    inline size_t claim(size_t max, bool steal, size_t& first) {
+        auto head{_head.load(std::memory_order_acquire)};
+        size_t n;
         do {
-            __verify_not_empty_read();
-        } while(_read_buffer.empty() and _writable);
-        if(_read_buffer.empty()) {
-            if(write_size() > 0)
-                std::cerr << "SHOULD NOT THROW\n";
-            throw EmptyBuffer();
-        }
-        T ret{std::move(_read_buffer.back())};
-        _read_buffer.pop_back();
-        return ret;
+            const auto available{_tail.load(std::memory_order_acquire) - head};
+            const auto wanted{std::min(max, steal ? (available+1) / 2 : available)};
+            for(n = 0; n < wanted and ready(head+n); ++n);
+            if(n == 0)
+                return 0;
+        } while(not _head.compare_exchange_weak(
+            head, head+n, std::memory_order_acq_rel, std::memory_order_acquire
+        ));
+        first = head;
+        return n;
+    }
+
+    /// \brief Free the slots of \a n graphs taken by claim() from index \a first.
+    inline void release(size_t first, size_t n) {
+        for(size_t i{0}; i < n; ++i)
+            _slots[(first+i) & _mask].sequence.store(first+i + _capacity, std::memory_order_seq_cst);
+        _producer->unpark();
+    }
+
+    /// \brief Get the oldest graph of the buffer without consuming it.
+    ///
+    /// Must only be called by the owner of the buffer, and only if no other
+    /// thread consumes from it. The slot is only freed by pop().
+    /// \param n Set to the number of vertices of the graph.
+    /// \return The rows of the graph, or nullptr if the buffer is empty.
+    inline graph* front(size_t& n) const {
+        const auto head{_head.load(std::memory_order_relaxed)};
+        if(not ready(head))
+            return nullptr;
+        n = _slots[head & _mask].order;
+        return rows_of(head);
+    }
+
+    /// \brief Release the graph returned by front().
+    inline void pop() {
+        const auto head{_head.load(std::memory_order_relaxed)};
+        _head.store(head+1, std::memory_order_seq_cst);
+        _slots[head & _mask].sequence.store(head + _capacity, std::memory_order_seq_cst);
+        _producer->unpark();
+    }
+
+    /// \brief Block until the buffer is non-empty or deactivated.
+    ///
+    /// Must only be called by the owner of the buffer.
+    /// \return false if the buffer is empty and deactivated.
+    inline bool wait_not_empty() {
+        for(unsigned spin{0}; ; ++spin) {
+            if(size() > 0)
+                return true;
+            if(not writable())  // the producer may have pushed right before disabling
+                return size() > 0;
+            if(spin < SPIN_LIMIT) {
+                cpu_relax();
+            } else {
+                _consumer.park([this]() {
+                    return size() > 0 or not writable();
+                });
+            }
+        }
     }
 
     /// \brief Determine whether or not the buffer is active.
     ///
     /// \return true if the buffer is active and false otherwise.
     inline bool writable() const {
-        return _writable;
+        return _writable.load(std::memory_order_seq_cst);
+    }
+
+    /// \brief Determine whether the producer cannot push anything anymore.
+    ///
+    /// Must only be called by the producer thread.
+    inline bool full() const {
+        const auto tail{_tail.load(std::memory_order_relaxed)};
+        return _slots[tail & _mask].sequence.load(std::memory_order_seq_cst) != tail;
+    }
+
+    /// \brief Number of graphs waiting in the buffer (possibly outdated).
+    inline size_t size() const {
+        const auto head{_head.load(std::memory_order_seq_cst)};
+        const auto tail{_tail.load(std::memory_order_seq_cst)};
+        return tail > head ? tail - head : 0;
+    }
+
+    /// \brief Write the whole slab, so that its memory is allocated by the
+    /// calling thread (i.e. on its NUMA node, under the first-touch policy).
+    ///
+    /// Must be called before the buffer is used.
+    inline void prefault() {
+        std::memset(_rows.get(), 0, _capacity * _stride * sizeof(graph));
     }
 
     /// \brief Enable the buffer.
     inline void enable_write() {
-        _writable = true;
+        _writable.store(true, std::memory_order_seq_cst);
     }
 
-    // \brief Disable the buffer
+    /// \brief Disable the buffer
+    ///
+    /// The consumers can still consume the remaining graphs.
     inline void disable_write() {
-        _should_swap = true;
-        _writable = false;
+        _writable.store(false, std::memory_order_seq_cst);
+        _consumer.unpark();
     }
+
+    friend class GraphBatch;
 private:
-    size_t                    _size;
-    std::vector<T>            _read_buffer;
-    std::vector<T>            _write_buffer;
-    volatile std::atomic_bool _writable;
-    volatile std::atomic_bool _should_swap;
-
-    inline void __verify_not_empty_read() {
-        using namespace std::chrono_literals;
-        if(read_size() > 0) {
-            return;
-        } else {
-            while(_writable and not _should_swap)
-                std::this_thread::sleep_for(10ms);
-            if(_should_swap)
-                std::swap(_read_buffer, _write_buffer);
-            _should_swap = false;
+    struct Slot {
+        std::atomic_size_t sequence;
+        size_t             order;
+    };
+
+    const size_t                    _capacity;
+    const size_t                    _mask;
+    const size_t                    _max_order;
+    const size_t                    _stride;  // number of setwords per slot
+    const std::unique_ptr<Slot[]>   _slots;
+    size_t                          _slab_size;  // number of setwords of the slab
+    SlabPool::Slab                  _rows;
+    std::shared_ptr<ParkingSpot>    _producer;
+
+    alignas(CACHE_LINE_SIZE) std::atomic_size_t _head{0};
+    alignas(CACHE_LINE_SIZE) std::atomic_size_t _tail{0};
+    alignas(CACHE_LINE_SIZE) std::atomic_bool _writable{true};
+    ParkingSpot _consumer;
+
+    inline graph* rows_of(size_t i) const {
+        return _rows.get() + (i & _mask) * _stride;
+    }
+
+    /* whether the graph of index i has been pushed and not claimed yet */
+    inline bool ready(size_t i) const {
+        return _slots[i & _mask].sequence.load(std::memory_order_acquire) == i+1;
+    }
+
+    /* hand the graph of index i (claimed by the caller) to f, then free its slot */
+    template <typename Function>
+    inline void consume(size_t i, Function& f) {
+        auto& slot{_slots[i & _mask]};
+        f(rows_of(i), slot.order);
+        slot.sequence.store(i + _capacity, std::memory_order_seq_cst);
+        _producer->unpark();
+    }
+};
+
+/// \brief Every buffer of a run, shared by the workers to steal from each other.
+class NautyBufferPool {
+public:
+    typedef std::shared_ptr<NautyContainerBuffer> BufferPtr;
+
+    /// Maximal number of graphs taken at once from another worker.
+    static constexpr size_t STEAL_BATCH{64};
+
+    NautyBufferPool(PipelineStatistics* statistics=nullptr, PipelineTrace* trace=nullptr):
+            _statistics{statistics}, _trace{trace} {
+    }
+    NautyBufferPool(const NautyBufferPool&) = delete;
+
+    /// \brief Steal graphs from the most loaded buffer (other than \a self).
+    ///
+    /// See NautyContainerBuffer::steal().
+    /// \return The number of stolen graphs.
+    template <typename Function>
+    inline size_t steal(Function& f, const NautyContainerBuffer* self) {
+        return steal_with(
+            [&f](NautyContainerBuffer& victim) { return victim.steal(f, STEAL_BATCH); },
+            self
+        );
+    }
+
+    /// \brief Claim a batch of graphs from the most loaded buffer (other than \a self).
+    ///
+    /// \param f Function called with the buffer, the index of the first
+    /// graph and the number of graphs (see NautyContainerBuffer::claim()).
+    /// It must release them.
+    /// \return The number of stolen graphs.
+    template <typename Function>
+    inline size_t steal_batch(Function& f, const NautyContainerBuffer* self) {
+        return steal_with(
+            [&f](NautyContainerBuffer& victim) {
+                size_t first;
+                const auto n{victim.claim(STEAL_BATCH, true, first)};
+                if(n > 0)
+                    f(victim, first, n);
+                return n;
+            },
+            self
+        );
+    }
+
+    /// \brief Determine whether every buffer is deactivated and empty.
+    inline bool done() const {
+        return std::all_of(
+            _buffers.cbegin(), _buffers.cend(),
+            [](const auto& buffer) {
+                return not buffer->writable() and buffer->size() == 0;
+            }
+        );
+    }
+
+    /// \brief Determine whether some buffer has graphs waiting.
+    inline bool has_work() const {
+        return std::any_of(
+            _buffers.cbegin(), _buffers.cend(),
+            [](const auto& buffer) { return buffer->size() > 0; }
+        );
+    }
+
+    /// \brief Sleep until there is work to steal or every buffer is done.
+    inline void wait_for_work() {
+        _idle.park([this]() { return has_work() or done(); });
+    }
+
+    /// \brief Block until some buffer has graphs or \a own is deactivated.
+    ///
+    /// Must only be called by the owner of \a own.
+    /// \return false if \a own is empty and deactivated.
+    inline bool wait_for_work(const NautyContainerBuffer& own) {
+        auto ready{[this, &own]() {
+            return own.size() > 0 or not own.writable() or has_work();
+        }};
+        for(unsigned spin{0}; not ready(); ++spin) {
+            if(spin < SPIN_LIMIT)
+                cpu_relax();
+            else
+                _idle.park(ready);
         }
+        // the producer may have pushed right before disabling
+        return own.writable() or own.size() > 0;
     }
 
-    friend class BaseNautyWorker;
-    template <GraphFunctionType Callback>
-    friend class NautyWorker;
+    /// \brief Get the buffer of index \a idx (in order of creation).
+    inline const BufferPtr& buffer(size_t idx) const {
+        return _buffers.at(idx);
+    }
 
-    /* NO LOCK IS PERFORMED HERE! */
-    inline size_t read_size() const {
-        return _read_buffer.size();
+    /// \brief Wake up the workers waiting for work (if any).
+    ///
+    /// Only costs a load when no worker is parked, hence it is called on
+    /// every push.
+    inline void notify() {
+        _idle.unpark();
     }
 
-    /* NO LOCK IS PERFORMED HERE! */
-    inline size_t write_size() const {
-        return _write_buffer.size();
+    /// \brief Ask the producers to stop and the workers to drop their graphs.
+    inline void request_stop() {
+        _stop.request_stop();
     }
-};
 
-/// Alias for a producer-consumer buffer containing graphs.
-/// See Graph.
-typedef ContainerBuffer<Graph> NautyContainerBuffer;
+    /// \brief Determine whether the run has been asked to stop.
+    inline bool stop_requested() const {
+        return _stop.stop_requested();
+    }
 
+    /// \brief Statistics of the run (nullptr if it is not instrumented).
+    inline PipelineStatistics* statistics() const {
+        return _statistics;
+    }
 
-/// \brief Container of multiple inter-thread buffers.
+    /// \brief Timeline of the run (nullptr if it is not traced).
+    inline PipelineTrace* trace() const {
+        return _trace;
+    }
+
+    friend class NautyContainer;
+private:
+    std::vector<BufferPtr> _buffers;
+    ParkingSpot            _idle;
+    std::stop_source       _stop;
+    PipelineStatistics*    _statistics;
+    PipelineTrace*         _trace;
+
+    /* apply take to the most loaded buffer other than self until it gets something */
+    template <typename Take>
+    inline size_t steal_with(Take&& take, const NautyContainerBuffer* self) {
+        while(true) {
+            NautyContainerBuffer* victim{nullptr};
+            size_t max_size{0};
+            for(auto& buffer : _buffers) {
+                auto size{buffer->size()};
+                if(buffer.get() != self and size > max_size) {
+                    victim = buffer.get();
+                    max_size = size;
+                }
+            }
+            if(victim == nullptr)
+                return 0;
+            if(auto n{take(*victim)}; n > 0)
+                return n;
+        }
+    }
+};
+
+/// \brief Container of multiple inter-thread buffers fed by a same producer.
 ///
+/// Graphs are dispatched to the buffers in a round-robin fashion.
 /// See NautyContainerBuffer.
 class NautyContainer {
 public:
-    NautyContainer(): _worker_buffers() {
+    NautyContainer(std::shared_ptr<NautyBufferPool> pool):
+            _worker_buffers(), _producer{std::make_shared<ParkingSpot>()},
+            _pool{std::move(pool)}, _next{0} {
     }
 
-    inline std::shared_ptr<NautyContainerBuffer> add_new_buffer(size_t buffer_size) {
-        _worker_buffers.push_back(
-            std::make_shared<NautyContainerBuffer>(buffer_size)
-        );
-        return _worker_buffers.back();
+    /// \brief Create the buffer of a worker.
+    ///
+    /// \param cpu If not negative, the buffer is allocated (and its memory
+    /// written) by a thread running on this CPU, hence on its NUMA node.
+    inline std::shared_ptr<NautyContainerBuffer> add_new_buffer(
+            size_t buffer_size, size_t max_order, int cpu=-1) {
+        std::shared_ptr<NautyContainerBuffer> buffer;
+        auto allocate{[this, &buffer, buffer_size, max_order, cpu]() {
+            // a recycled slab would stay on the NUMA node it was first written from
+            buffer = std::make_shared<NautyContainerBuffer>(
+                buffer_size, max_order, _producer, cpu < 0
+            );
+        }};
+        if(cpu < 0) {
+            allocate();
+        } else {
+            run_on_cpu(cpu, [&allocate, &buffer]() {
+                allocate();
+                buffer->prefault();
+            });
+        }
+        _worker_buffers.push_back(buffer);
+        _pool->_buffers.push_back(buffer);
+        return buffer;
     }
 
-    template <typename... Args>
-    inline void emplace(Args&&... args) {
-        Graph G(std::forward<Args>(args)...);
-        while(true) {
-            for(auto& buffer : _worker_buffers) {
-                if(buffer->writable() and buffer->push(G))
-                    return;
-            }
-            using namespace std::chrono_literals;
-            std::this_thread::sleep_for(1ms);
-        }
+    /// \brief Copy a graph in the nauty format into one of the buffers.
+    inline void emplace(const graph* G, size_t n) {
+        dispatch(n, [G, n](graph* rows) {
+            memcpy(rows, G, SETWORDSNEEDED(n)*n*sizeof(graph));
+        });
+    }
+
+    /// \brief Hand a graph generated by geng to the run.
+    ///
+    /// The graph is either processed in place by the sink of the container
+    /// (see set_sink()), or copied into one of the buffers.
+    inline void output(graph* G, size_t n) {
+        if(_sink != nullptr)
+            consume(G, n);
+        else
+            emplace(G, n);
+    }
+
+    /// \brief Process every graph in the producer thread instead of the buffers.
+    ///
+    /// \a sink is called with \a state on the rows of geng/gentreeg, which
+    /// are only valid during the call.
+    inline void set_sink(void (*sink)(void*, graph*, size_t), void* state) {
+        _sink = sink;
+        _sink_state = state;
+    }
+
+    /// \brief Determine whether the producer should stop generating graphs.
+    inline bool stop_requested() const {
+        return _pool->stop_requested();
+    }
+
+    /// \brief Record the activity of the producer in \a probe and/or \a track.
+    inline void instrument(PipelineStatistics::ProducerProbe* probe,
+            PipelineTrace::Track* track) {
+        _probe = probe;
+        _track = track;
+        _burst_start = std::chrono::steady_clock::now();
     }
 
     inline void _add_gentree_tree(int* parents, size_t n) {
-        emplace(parents, n);
+        auto fill{[parents, n](graph* rows) {
+            const size_t m{SETWORDSNEEDED(n)};
+            EMPTYGRAPH(rows, m, n);
+            for(size_t v{2}; v <= n; ++v)
+                ADDONEEDGE(rows, v-1, parents[v]-1, m);  // gentreeg uses 1..n
+        }};
+        if(_sink != nullptr) {
+            _scratch.resize(SETWORDSNEEDED(n)*n);
+            fill(_scratch.data());
+            consume(_scratch.data(), n);
+        } else {
+            dispatch(n, fill);
+        }
     }
 
     friend class Nauty;
 private:
     typedef std::vector<std::shared_ptr<NautyContainerBuffer>> ContainerVector;
     ContainerVector _worker_buffers;
+    std::shared_ptr<ParkingSpot> _producer;
+    std::shared_ptr<NautyBufferPool> _pool;
+    size_t _next;
+    int _cpu{-1};  // CPU of the producer (if pinned)
+    PipelineStatistics::ProducerProbe* _probe{nullptr};
+    PipelineTrace::Track* _track{nullptr};
+    std::chrono::steady_clock::time_point _burst_start;  // when traced
+    void (*_sink)(void*, graph*, size_t){nullptr};  // inline runs only
+    void* _sink_state{nullptr};
+    std::vector<graph> _scratch;  // rows of the last tree of gentreeg (inline runs)
+
+    /* process a graph in place; graphs produced after a stop request are dropped */
+    inline void consume(graph* G, size_t n) {
+        if(stop_requested())
+            return;
+        if(_probe != nullptr) [[unlikely]]
+            _probe->record_push(0);
+        _sink(_sink_state, G, n);
+    }
+
+    /* graphs produced after a stop request are dropped */
+    template <typename Fill>
+    inline void dispatch(size_t n, Fill&& fill) {
+        const auto nb_buffers{_worker_buffers.size()};
+        std::chrono::steady_clock::time_point stalled_since;
+        for(unsigned spin{0}; not stop_requested(); ++spin) {
+            for(size_t i{0}; i < nb_buffers; ++i) {
+                auto& buffer{_worker_buffers[_next]};
+                if(++_next == nb_buffers)
+                    _next = 0;
+                if(buffer->push(n, fill)) {
+                    _pool->notify();
+                    if(_probe != nullptr) [[unlikely]]
+                        _probe->record_push(buffer->size());
+                    if(spin > 0)
+                        end_stall(stalled_since);
+                    return;
+                }
+            }
+            if(spin == 0)
+                stalled_since = begin_stall();
+            // every buffer is full: idle workers can help
+            _pool->notify();
+            if(spin < SPIN_LIMIT)
+                cpu_relax();
+            else
+                _producer->park([this]() { return not all_full() or stop_requested(); });
+        }
+    }
+
+    inline bool all_full() const {
+        return std::all_of(
+            _worker_buffers.cbegin(), _worker_buffers.cend(),
+            [](const auto& buffer) { return buffer->full(); }
+        );
+    }
+
+    /* time at which the buffers got full, if instrumented */
+    inline std::chrono::steady_clock::time_point begin_stall() {
+        if(_probe == nullptr and _track == nullptr) [[likely]]
+            return {};
+        const auto now{std::chrono::steady_clock::now()};
+        if(_track != nullptr)
+            _track->record(PipelineTrace::Event::PRODUCE, _burst_start, now);
+        return now;
+    }
+
+    inline void end_stall(std::chrono::steady_clock::time_point since) {
+        if(_probe == nullptr and _track == nullptr) [[likely]]
+            return;
+        const auto now{std::chrono::steady_clock::now()};
+        if(_probe != nullptr)
+            _probe->record_stall(now - since);
+        if(_track != nullptr) {
+            _track->record(PipelineTrace::Event::STALL, since, now);
+            _burst_start = now;
+        }
+    }
 
     inline void set_over() {
+        if(_probe != nullptr)
+            _probe->finish();
+        if(_track != nullptr)
+            _track->record(
+                PipelineTrace::Event::PRODUCE, _burst_start, std::chrono::steady_clock::now()
+            );
         for(auto& buffer : _worker_buffers)
             buffer->disable_write();
+        _pool->notify();
+    }
+};
+
+/// \brief Consecutive graphs of a buffer, read in place.
+///
+/// Graphs are stored as packed adjacency rows (`SETWORDSNEEDED(order(i))`
+/// setwords per vertex), which can be processed directly, e.g. to compute
+/// a same property of all the graphs of the batch at once.
+/// Indexing (or iterating over) the batch gives a Graph bound to those rows
+/// instead. Since this Graph is shared by the whole batch, it is only valid
+/// until the next graph is accessed.
+///
+/// A batch is only valid during the call of the callback it is given to.
+class GraphBatch {
+public:
+    /// \brief Iterator over the graphs of a batch. See GraphBatch.
+    class iterator {
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef Graph value_type;
+
+        iterator() = default;
+
+        inline Graph& operator*() const {
+            return (*_batch)[_idx];
+        }
+
+        inline iterator& operator++() {
+            ++_idx;
+            return *this;
+        }
+
+        inline iterator operator++(int) {
+            auto ret{*this};
+            ++_idx;
+            return ret;
+        }
+
+        inline bool operator==(const iterator& other) const {
+            return _idx == other._idx;
+        }
+    private:
+        const GraphBatch* _batch{nullptr};
+        size_t _idx{0};
+
+        iterator(const GraphBatch* batch, size_t idx): _batch{batch}, _idx{idx} {
+        }
+
+        friend class GraphBatch;
+    };
+
+    GraphBatch(const GraphBatch&) = delete;
+
+    /// \brief Number of graphs in the batch.
+    inline size_t size() const {
+        return _size;
+    }
+
+    /// \brief Number of vertices of the i-th graph.
+    inline size_t order(size_t i) const {
+        return _buffer->_slots[(_first+i) & _buffer->_mask].order;
+    }
+
+    /// \brief Packed adjacency rows of the i-th graph.
+    inline const graph* rows(size_t i) const {
+        return _buffer->rows_of(_first+i);
+    }
+
+    /// \brief Read-only view over the i-th graph (valid during the whole call).
+    inline GraphView view(size_t i) const {
+        return GraphView(rows(i), order(i));
+    }
+
+    /// \brief The i-th graph (only valid until another graph is accessed).
+    inline Graph& operator[](size_t i) const {
+        _view->rebind(_buffer->rows_of(_first+i), order(i));
+        return *_view;
+    }
+
+    inline iterator begin() const {
+        return iterator(this, 0);
+    }
+
+    inline iterator end() const {
+        return iterator(this, _size);
+    }
+
+    friend class NautyConsumer;
+private:
+    const NautyContainerBuffer* _buffer;
+    size_t _first;
+    size_t _size;
+    Graph* _view;
+
+    GraphBatch(const NautyContainerBuffer& buffer, size_t first, size_t n, Graph& view):
+            _buffer{&buffer}, _first{first}, _size{n}, _view{&view} {
     }
 };
 
 /*      *************** Workers ***************      */
 
-class BaseNautyWorker {
+/// \brief Thread consuming the graphs of a buffer.
+///
+/// A worker processes the graphs of its own buffer, and steals batches of
+/// graphs from the other workers when it has nothing left to do, until every
+/// buffer is deactivated and empty.
+///
+/// Once the run is asked to stop, the remaining graphs are released without
+/// being processed.
+class NautyConsumer {
 public:
-    BaseNautyWorker(std::shared_ptr<NautyContainerBuffer> buffer):
-            _buffer{std::move(buffer)} {
+    NautyConsumer(std::shared_ptr<NautyContainerBuffer> buffer,
+            std::shared_ptr<NautyBufferPool> pool):
+            _buffer{std::move(buffer)}, _pool{std::move(pool)} {
     }
 
-    ~BaseNautyWorker() = default;
+    ~NautyConsumer() = default;
 
-    void run() {
+    /// \brief Record the activity of the worker in \a probe and/or \a track.
+    inline void instrument(PipelineStatistics::WorkerProbe* probe,
+            PipelineTrace::Track* track) {
+        _probe = probe;
+        _track = track;
+    }
+protected:
+    typedef std::shared_ptr<NautyContainerBuffer> BufferPtr;
+    typedef std::chrono::steady_clock clock;
+    BufferPtr  _buffer;
+    std::shared_ptr<NautyBufferPool> _pool;
+    PipelineStatistics::WorkerProbe* _probe{nullptr};
+    PipelineTrace::Track* _track{nullptr};
+
+    /* consume with own(), or with steal() when the own buffer is empty, until
+     * the own buffer is over, then with steal() until every buffer is; both
+     * return whether they got something */
+    template <typename Own, typename Steal>
+    inline void work(Own&& own, Steal&& steal) {
+        do {
+            while(own() or steal());
+        } while(waiting([this]() { return _pool->wait_for_work(*_buffer); }));
+        // own buffer is over: help the others until the end
         while(true) {
-            try {
-                Graph G{_buffer->pop()};
-                (*this)(G);
-            } catch(NautyContainerBuffer::EmptyBuffer&) {
+            if(steal())
+                continue;
+            if(_pool->done())
                 break;
-            }
+            waiting([this]() { _pool->wait_for_work(); return true; });
+        }
+    }
+
+    /* call wait(), accounting for the time it takes as idle time */
+    template <typename Wait>
+    inline bool waiting(Wait&& wait) {
+        if(_probe == nullptr and _track == nullptr) [[likely]]
+            return wait();
+        const auto start{clock::now()};
+        const bool ret{wait()};
+        const auto end{clock::now()};
+        if(_probe != nullptr)
+            _probe->record_wait(end - start);
+        if(_track != nullptr)
+            _track->record(PipelineTrace::Event::WAIT, start, end);
+        return ret;
+    }
+
+    /* call(), accounting for the processing of nb_graphs graphs
+     * (traced once every sample period) */
+    template <typename Call>
+    inline void timed(size_t nb_graphs, Call&& call) {
+        const bool traced{_track != nullptr and _track->sample(nb_graphs)};
+        if(_probe == nullptr and not traced) [[likely]] {
+            call();
+            return;
         }
+        const auto start{clock::now()};
+        call();
+        const auto end{clock::now()};
+        if(_probe != nullptr)
+            _probe->record_call(nb_graphs, end - start);
+        if(traced)
+            _track->record(
+                PipelineTrace::Event::CALLBACK, start, end, static_cast<std::uint32_t>(nb_graphs)
+            );
+    }
+
+    /* account for nb_graphs stolen graphs, and tell whether there were any */
+    inline bool stole(size_t nb_graphs) {
+        if(nb_graphs == 0)
+            return false;
+        if(_probe != nullptr)
+            _probe->record_steal(nb_graphs);
+        if(_track != nullptr) {
+            const auto now{clock::now()};
+            _track->record(
+                PipelineTrace::Event::STEAL, now, now, static_cast<std::uint32_t>(nb_graphs)
+            );
+        }
+        return true;
+    }
+
+    /* call f on x, and stop the run if f returns CallbackStatus::STOP */
+    template <typename Function, typename Arg>
+    inline void invoke(Function& f, Arg& x) {
+        if constexpr(std::is_same_v<std::invoke_result_t<Function&, Arg&>, CallbackStatus>) {
+            if(f(x) == CallbackStatus::STOP)
+                _pool->request_stop();
+        } else {
+            f(x);
+        }
+    }
+
+    static inline Graph make_view() {
+        return Graph::make_view();
+    }
+
+    static inline GraphBatch make_batch(const NautyContainerBuffer& buffer,
+            size_t first, size_t n, Graph& view) {
+        return GraphBatch(buffer, first, n, view);
+    }
+};
+
+/// \brief Worker calling its callback on every graph.
+///
+/// The callback is given a same Graph object over and over, bound to the
+/// rows of the current graph in the buffer: it is only valid during the
+/// call. Moving it (or using Graph::copy()) makes a graph owning its rows.
+class BaseNautyWorker : public NautyConsumer {
+public:
+    using NautyConsumer::NautyConsumer;
+
+    void run() {
+        auto view{make_view()};
+        auto process{[this, &view](graph* rows, size_t n) {
+            if(_pool->stop_requested())
+                return;
+            view.rebind(rows, n);
+            timed(1, [this, &view]() { (*this)(view); });
+        }};
+        work(
+            [this, &process]() { return _buffer->consume_one(process); },
+            [this, &process]() { return stole(_pool->steal(process, _buffer.get())); }
+        );
     }
 
     virtual void operator()(Graph& G) = 0;
+};
+
+/// \brief Worker calling its callback on batches of graphs.
+///
+/// The callback is called (without virtual dispatch) with a GraphBatch of
+/// up to BATCH_SIZE graphs taken at once from its buffer, or stolen from
+/// another worker.
+template <GraphBatchFunctionType BatchFunction>
+class NautyBatchWorker final : public NautyConsumer {
+public:
+    typedef BatchFunction callback_t;
+
+    /// Maximal number of graphs taken at once from the own buffer.
+    static constexpr size_t BATCH_SIZE{64};
+
+    NautyBatchWorker(std::shared_ptr<NautyContainerBuffer> buffer,
+            std::shared_ptr<NautyBufferPool> pool, callback_t callback):
+            NautyConsumer(buffer, pool), _callback{callback} {
+    }
+
+    NautyBatchWorker(NautyBatchWorker&) = delete;
+    NautyBatchWorker(NautyBatchWorker&&) = default;
+
+    void run() {
+        auto view{make_view()};
+        auto process{[this, &view](NautyContainerBuffer& buffer, size_t first, size_t n) {
+            if(not _pool->stop_requested()) {
+                auto batch{make_batch(buffer, first, n, view)};
+                timed(n, [this, &batch]() { invoke(_callback, batch); });
+            }
+            buffer.release(first, n);
+        }};
+        work(
+            [this, &process]() {
+                size_t first;
+                const auto n{_buffer->claim(BATCH_SIZE, false, first)};
+                if(n > 0)
+                    process(*_buffer, first, n);
+                return n > 0;
+            },
+            [this, &process]() { return stole(_pool->steal_batch(process, _buffer.get())); }
+        );
+    }
 protected:
-    typedef std::shared_ptr<NautyContainerBuffer> BufferPtr;
-    BufferPtr  _buffer;
+    callback_t _callback;
+};
+
+/// \brief Worker calling its callback on a GraphView of every graph.
+///
+/// Unlike BaseNautyWorker, the graphs are given to the callback without
+/// virtual dispatch nor any Graph object to rebind: the view only points to
+/// the rows of the graph in the buffer, and is only valid during the call.
+template <GraphViewFunctionType ViewFunction>
+class NautyViewWorker final : public NautyConsumer {
+public:
+    typedef ViewFunction callback_t;
+
+    NautyViewWorker(std::shared_ptr<NautyContainerBuffer> buffer,
+            std::shared_ptr<NautyBufferPool> pool, callback_t callback):
+            NautyConsumer(buffer, pool), _callback{callback} {
+    }
+
+    NautyViewWorker(NautyViewWorker&) = delete;
+    NautyViewWorker(NautyViewWorker&&) = default;
+
+    void run() {
+        auto process{[this](graph* rows, size_t n) {
+            if(_pool->stop_requested())
+                return;
+            GraphView view(rows, n);
+            timed(1, [this, &view]() { invoke(_callback, view); });
+        }};
+        work(
+            [this, &process]() { return _buffer->consume_one(process); },
+            [this, &process]() { return stole(_pool->steal(process, _buffer.get())); }
+        );
+    }
+protected:
+    callback_t _callback;
 };
 
 template <GraphFunctionType GraphFunction>
@@ -308,8 +1338,9 @@ class NautyWorker final : public BaseNautyWorker {
 public:
     typedef GraphFunction callback_t;
 
-    NautyWorker(std::shared_ptr<NautyContainerBuffer> buffer, callback_t callback):
-            BaseNautyWorker(buffer), _callback{callback} {
+    NautyWorker(std::shared_ptr<NautyContainerBuffer> buffer,
+            std::shared_ptr<NautyBufferPool> pool, callback_t callback):
+            BaseNautyWorker(buffer, pool), _callback{callback} {
     }
 
     NautyWorker(NautyWorker&) = delete;
@@ -319,16 +1350,16 @@ public:
     ~NautyWorker() noexcept(false) {
         if(_buffer->writable())
             throw std::runtime_error("Destroying a worker with a readable buffer.");
-        if(_buffer->read_size() > 0)
-            std::cerr << "Destroying worker with read buffer size "
-                      << _buffer->read_size() << std::endl;
+        if(_buffer->size() > 0)
+            std::cerr << "Destroying worker with buffer size "
+                      << _buffer->size() << std::endl;
     }
 #else
     ~NautyWorker() = default;
 #endif
 
     virtual void operator()(Graph& G) override final {
-        _callback(G);
+        invoke(_callback, G);
     }
 protected:
     callback_t _callback;
@@ -337,12 +1368,13 @@ protected:
 template <GraphRefFunctionType Callback>
 class NautyWorkerWrapper final : public BaseNautyWorker {
 public:
-    NautyWorkerWrapper(std::shared_ptr<NautyContainerBuffer> buffer):
-            BaseNautyWorker(buffer), _callback() {
+    NautyWorkerWrapper(std::shared_ptr<NautyContainerBuffer> buffer,
+            std::shared_ptr<NautyBufferPool> pool):
+            BaseNautyWorker(buffer, pool), _callback() {
     }
 
     virtual void operator()(Graph& G) override final {
-        _callback(G);
+        invoke(_callback, G);
     }
 
     inline void join(NautyWorkerWrapper& other) {
@@ -360,9 +1392,287 @@ private:
     Callback _callback;
 };
 
+/// \brief Type of the worker running a callback given by value.
+template <typename Function>
+struct NautyWorkerFor {
+    typedef NautyWorker<Function> type;
+};
+
+template <GraphBatchFunctionType Function>
+struct NautyWorkerFor<Function> {
+    typedef NautyBatchWorker<Function> type;
+};
+
+template <GraphViewFunctionType Function>
+struct NautyWorkerFor<Function> {
+    typedef NautyViewWorker<Function> type;
+};
+
+/*      *************** Generator ***************      */
+
+/// \brief Range of the graphs generated by geng/gentreeg or read from a file.
+///
+/// Graphs are consumed lazily by the thread iterating over the range, with
+/// no worker thread: geng/gentreeg run in their own producer threads (they
+/// cannot be suspended from their output procedure) and fill bounded buffers
+/// ahead of the iteration, so that the iterating thread only waits when
+/// it has caught up with the producers. Graphs read from a file are parsed
+/// directly by the iterating thread.
+///
+/// Like the graph given to a callback, the graph an iterator points to is
+/// only valid until the iterator is incremented; moving it (or using
+/// Graph::copy()) makes a graph owning its rows.
+///
+/// Destroying the range before the end stops the producers.
+/// See Nauty::generate().
+///
+/// **Example**:
+/// \include iterators/generate.cpp
+class GraphGenerator {
+public:
+    /// \brief Input iterator over a GraphGenerator.
+    class iterator {
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef Graph value_type;
+
+        iterator() = default;
+
+        inline Graph& operator*() const {
+            return _generator->_view;
+        }
+
+        inline Graph* operator->() const {
+            return &_generator->_view;
+        }
+
+        inline iterator& operator++() {
+            _generator->advance();
+            return *this;
+        }
+
+        inline void operator++(int) {
+            ++*this;
+        }
+
+        inline bool operator==(std::default_sentinel_t) const {
+            return _generator->_over;
+        }
+    private:
+        GraphGenerator* _generator{nullptr};
+
+        iterator(GraphGenerator* generator): _generator{generator} {
+        }
+
+        friend class GraphGenerator;
+    };
+
+    GraphGenerator(const GraphGenerator&) = delete;
+    GraphGenerator(GraphGenerator&&) = delete;
+
+    ~GraphGenerator() {
+        if(_file != nullptr) {
+            if(_owns_file)
+                fclose(_file);
+            FREES(_rows);
+            return;
+        }
+        _pool->request_stop();
+        // release the pending graphs so that no producer stays parked
+        for(auto& buffer : _buffers)
+            while(buffer->wait_not_empty())
+                buffer->pop();
+        for(auto& thread : _producers)
+            thread.join();
+    }
+
+    /// \brief Start iterating (at most once).
+    inline iterator begin() {
+        if(not _started) {
+            _started = true;
+            advance();
+        }
+        return iterator(this);
+    }
+
+    inline std::default_sentinel_t end() const {
+        return std::default_sentinel;
+    }
+
+    friend class Nauty;
+private:
+    typedef std::shared_ptr<NautyContainerBuffer> BufferPtr;
+
+    Graph _view;
+    bool  _started{false};
+    bool  _over{false};
+    bool  _holding{false};  // whether the current graph is still in a buffer
+
+    /* generation by geng/gentreeg */
+    std::shared_ptr<NautyBufferPool>             _pool;
+    std::vector<std::unique_ptr<NautyContainer>> _containers;
+    std::vector<std::thread>                     _producers;
+    std::vector<BufferPtr>                       _buffers;  // the ones not over yet
+    size_t                                       _current{0};
+
+    /* reading from a file */
+    FILE*  _file{nullptr};
+    bool   _owns_file{false};
+    graph* _rows{nullptr};
+    int    _max_order{0};
+
+    /* the producers must already be started and feed one buffer each */
+    GraphGenerator(std::shared_ptr<NautyBufferPool> pool,
+            std::vector<std::unique_ptr<NautyContainer>>&& containers,
+            std::vector<std::thread>&& producers):
+            _view{Graph::make_view()},
+            _pool{std::move(pool)},
+            _containers{std::move(containers)},
+            _producers{std::move(producers)} {
+        for(size_t i{0}; i < _containers.size(); ++i)
+            _buffers.push_back(_pool->buffer(i));
+    }
+
+    GraphGenerator(FILE* f, bool owns_file, size_t max_graph_size):
+            _view{Graph::make_view()},
+            _file{f}, _owns_file{owns_file},
+            _max_order{static_cast<int>(max_graph_size)} {
+        _rows = static_cast<graph*>(ALLOCS(
+            SETWORDSNEEDED(_max_order) * _max_order, sizeof(graph)
+        ));
+    }
+
+    inline void advance() {
+        if(_file != nullptr)
+            _over = not read_next();
+        else
+            _over = not pop_next();
+    }
+
+    inline bool read_next() {
+        int m{SETWORDSNEEDED(_max_order)};
+        int n{_max_order};
+        boolean directed;
+        if(readgg(_file, _rows, 0, &m, &n, &directed) == nullptr)
+            return false;
+        _view.rebind(_rows, n);
+        return true;
+    }
+
+    inline bool pop_next() {
+        if(_holding) {
+            _buffers[_current]->pop();
+            _holding = false;
+        }
+        while(not _buffers.empty()) {
+            for(size_t i{0}; i < _buffers.size(); ++i) {
+                const auto idx{(_current + i) % _buffers.size()};
+                size_t n;
+                if(auto rows{_buffers[idx]->front(n)}; rows != nullptr) {
+                    _current = idx;
+                    _holding = true;
+                    _view.rebind(rows, n);
+                    return true;
+                }
+            }
+            // every buffer is empty: wait for one of them and forget it once over
+            if(not _buffers[_current]->wait_not_empty()) {
+                _buffers.erase(_buffers.begin() + _current);
+                if(_current == _buffers.size())
+                    _current = 0;
+            }
+        }
+        return false;
+    }
+};
+
+/*      *************** Handles ***************      */
+
+/// \brief Handle on a run started by Nauty::spawn().
+///
+/// The run goes on in the background (its producers and workers are driven
+/// by a thread of their own) until it is over or stopped.
+/// Destroying a handle waits for the end of its run.
+///
+/// \tparam Result The result of the run (`void` for callbacks given by value).
+template <typename Result>
+class NautyHandle {
+public:
+    NautyHandle(NautyHandle&&) = default;
+    NautyHandle(const NautyHandle&) = delete;
+    NautyHandle& operator=(const NautyHandle&) = delete;
+    NautyHandle& operator=(NautyHandle&&) = delete;
+
+    ~NautyHandle() {
+        if(_thread.joinable())
+            _thread.join();
+    }
+
+    /// \brief Block until the run is over.
+    inline void wait() const {
+        _result.wait();
+    }
+
+    /// \brief Determine whether the run is over, without blocking.
+    inline bool poll() const {
+        return _result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    /// \brief Wait for the end of the run and get its result.
+    ///
+    /// Can only be called once. Rethrows the exception that ended the run (if any).
+    inline Result get() {
+        return _result.get();
+    }
+
+    /// \brief Ask the run to stop as soon as possible (see Nauty::run_async()).
+    inline void request_stop() {
+        _stop.request_stop();
+    }
+
+    friend class Nauty;
+private:
+    std::stop_source    _stop;
+    std::future<Result> _result;
+    std::thread         _thread;
+
+    /* start task(stop_token) in a new thread */
+    template <typename Task>
+    NautyHandle(Task&& task, std::stop_token stop_token) {
+        if(stop_token.stop_possible())
+            _link = std::make_unique<std::stop_callback<StopForwarder>>(
+                std::move(stop_token), StopForwarder{_stop}
+            );
+        std::packaged_task<Result(std::stop_token)> packaged(std::forward<Task>(task));
+        _result = packaged.get_future();
+        _thread = std::thread(std::move(packaged), _stop.get_token());
+        rename_thread(_thread, "nautypp-run");
+    }
+
+    /* forward a stop requested by the caller of Nauty::spawn() */
+    struct StopForwarder {
+        std::stop_source stop;
+        inline void operator()() {
+            stop.request_stop();
+        }
+    };
+    std::unique_ptr<std::stop_callback<StopForwarder>> _link;
+};
+
 /*      *************** Nauty ***************      */
 
+/// \brief Callback type whose results can be saved in shard files.
+///
+/// See Nauty::run_shard() and Nauty::merge_shards().
+template <typename Callback>
+concept ShardableCallback = GraphRefFunctionType<Callback>
+    and serialization::Serializable<typename Callback::ResultType>
+    and std::constructible_from<Callback, typename Callback::ResultType&&>;
+
 /// \brief Wrapper for geng/gentreeg
+///
+/// Every run owns its producers, containers and workers: runs started from
+/// different threads (with the same Nauty object or not) are independent.
 class Nauty {
 public:
     Nauty() = default;
@@ -379,22 +1689,25 @@ public:
     /// \param max_graph_size The maximal order of a graph in the file.
     /// \param nb_workers The number of threads to create to dispatch the generated graphs.
     /// \param worker_buffer_size The buffer size for every worker.
+    /// \param stop_token Stops reading the file when a stop is requested.
     ///
     /// **Example**:
     /// \include multithreaded/graph_reader.cpp
-    template <GraphFunctionType GraphFunction>
+    template <NautyCallbackType GraphFunction>
     void run_async(GraphFunction callback,
             FILE* f,
             size_t max_graph_size=100,
             size_t nb_workers=std::thread::hardware_concurrency(),
-            size_t worker_buffer_size=5'000) {
-        auto [worker_threads, workers] = make_workers(
-            callback, nb_workers, worker_buffer_size
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) {
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        auto [worker_threads, workers, pool] = make_workers(
+            containers, callback, nb_workers, worker_buffer_size, 1, max_graph_size
         );
-        auto reader_thread{start_reader_thread(f, max_graph_size)};
+        auto stop_link{forward_stop(std::move(stop_token), pool)};
+        auto reader_thread{start_reader_thread(containers.front().get(), f, max_graph_size)};
         reader_thread.join();
-        for(size_t i{0}; i < nb_workers; ++i)
-            worker_threads.at(i).join();
+        join_all(worker_threads);
     }
 
     /// \brief Run some callback on all graphs found in a file.
@@ -406,44 +1719,72 @@ public:
     /// \param max_graph_size The maximal order of a graph in the file.
     /// \param nb_workers The number of threads to create to dispatch the generated graphs.
     /// \param worker_buffer_size The buffer size for every worker.
+    /// \param stop_token Stops reading the file when a stop is requested.
     ///
     /// **Example**:
     /// \include multithreaded/graph_reader.cpp
-    template <GraphFunctionType GraphFunction>
+    template <NautyCallbackType GraphFunction>
     void run_async(GraphFunction callback,
             const std::string& file_path,
             size_t max_graph_size=100,
             size_t nb_workers=std::thread::hardware_concurrency(),
-            size_t worker_buffer_size=5'000) {
-        auto [worker_threads, workers] = make_workers(
-            callback, nb_workers, worker_buffer_size
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) {
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        auto [worker_threads, workers, pool] = make_workers(
+            containers, callback, nb_workers, worker_buffer_size, 1, max_graph_size
         );
-        auto reader_thread{start_reader_thread(file_path, max_graph_size)};
+        auto stop_link{forward_stop(std::move(stop_token), pool)};
+        auto reader_thread{start_reader_thread(
+            containers.front().get(), file_path, max_graph_size
+        )};
         reader_thread.join();
-        for(size_t i{0}; i < nb_workers; ++i)
-            worker_threads.at(i).join();
+        join_all(worker_threads);
     }
 
     /// \brief Run some callback on all graphs generated by geng/gentreeg.
     ///
+    /// If `parameters.nb_producers` is larger than 1, that many instances of
+    /// geng/gentreeg run concurrently and each of them feeds its own share of
+    /// the workers.
+    ///
+    /// The callback either takes a Graph, a GraphView (see NautyViewWorker),
+    /// or a GraphBatch to process several graphs per call (see NautyBatchWorker).
+    ///
+    /// The run ends early if the callback returns CallbackStatus::STOP or if
+    /// a stop is requested on \a stop_token: the producers give up the
+    /// generation (geng prunes every remaining branch of its search) and the
+    /// graphs that are still pending are dropped without being processed.
+    /// Graphs being processed at that moment are not interrupted.
+    ///
     /// \param callback The function to execute on every graph.
+    /// \param parameters The parameters given to geng/gentreeg.
     /// \param nb_workers The number of threads to create to dispatch the generated graphs.
     /// \param worker_buffer_size The buffer size for every worker.
+    /// \param stop_token Token on which the caller can request the run to stop.
     ///
     /// **Example**:
     /// \include multithreaded/count_triangle_free_graphs.cpp
-    template <GraphFunctionType GraphFunction>
+    /// \include multithreaded/counterexample.cpp
+    template <NautyCallbackType GraphFunction>
     void run_async(GraphFunction callback,
             const NautyParameters& parameters,
             size_t nb_workers=std::thread::hardware_concurrency(),
-            size_t worker_buffer_size=5'000) {
-        auto [worker_threads, workers] = make_workers(
-            callback, nb_workers, worker_buffer_size
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) {
+        check_parameters(parameters);
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        const auto nb_producers{nb_producers_for(parameters, nb_workers)};
+        auto [worker_threads, workers, pool] = make_workers(
+            containers, callback, nb_workers, worker_buffer_size,
+            nb_producers, max_order_for(parameters),
+            setup_for(parameters, nb_producers, nb_workers)
         );
-        auto geng_thread{start_nauty(parameters)};
-        geng_thread.join();
-        for(size_t i{0}; i < nb_workers; ++i)
-            worker_threads.at(i).join();
+        auto stop_link{forward_stop(std::move(stop_token), pool)};
+        auto producer_threads{start_nauty(parameters, containers)};
+        join_all(producer_threads);
+        join_all(worker_threads);
+        finish_instrumentation(*pool);
     }
 
     /// Alternative version of run_async.
@@ -453,49 +1794,306 @@ public:
     /// The template type \a Callback must:
     /// - provide a type `Callback::ResultType`
     /// - define `operator()(const Graph&)`
-    /// - define `join(Callback&& other)`
+    /// - define `join(Callback&& other)`, which must be associative since
+    ///   the results of the workers are joined in parallel (see tree_reduce())
     /// - define `ResultType&& get()`
     ///
+    /// `operator()` may return a CallbackStatus to stop the run early. The
+    /// result of a stopped run only accounts for the graphs processed so far.
+    ///
     /// **Example**:
     /// \include multithreaded/heavy_callback.cpp
     template <GraphRefFunctionType Callback>
     auto run_async(
             const NautyParameters& parameters,
             size_t nb_workers=std::thread::hardware_concurrency(),
-            size_t worker_buffer_size=5'000) -> typename Callback::ResultType {
-        Nauty::reset_container();
-        std::vector<NautyWorkerWrapper<Callback>> wrappers;
-        std::vector<std::thread> workers;
-        wrappers.reserve(nb_workers);
-        workers.reserve(nb_workers);
-        static char name_buffer[32];
-        for(size_t i{0}; i < nb_workers; ++i) {
-            auto worker_buffer{Nauty::_container->add_new_buffer(worker_buffer_size)};
-            wrappers.emplace_back(worker_buffer);
-            workers.emplace_back(
-                &NautyWorkerWrapper<Callback>::run,
-                std::addressof(wrappers.back())
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) -> typename Callback::ResultType {
+        bool stopped;
+        return run_wrappers<Callback>(
+            parameters, nb_workers, worker_buffer_size, std::move(stop_token), stopped
+        );
+    }
+
+    /// \brief Run some callback on all graphs generated by geng/gentreeg,
+    /// in the threads running geng/gentreeg.
+    ///
+    /// Every thread runs an instance of geng/gentreeg on its own class of
+    /// graphs (as with NautyParameters::nb_producers), and calls its own copy
+    /// of the callback on every graph it generates, directly in the output
+    /// procedure of geng/gentreeg: graphs are neither copied nor handed over
+    /// to other threads. This is the fastest way to run callbacks that are
+    /// cheap compared to the generation itself (e.g. counting graphs or
+    /// checking their degrees), but the load is not balanced between the
+    /// threads, and a slow callback slows down the generation.
+    ///
+    /// The Graph (or GraphView) given to the callback is bound to the rows of
+    /// geng/gentreeg and is only valid during the call (copy it to keep it).
+    ///
+    /// The run ends early if the callback returns CallbackStatus::STOP or if
+    /// a stop is requested on \a stop_token.
+    ///
+    /// \param callback The function to execute on every graph.
+    /// \param parameters The parameters given to geng/gentreeg
+    ///                   (NautyParameters::nb_producers is ignored).
+    /// \param nb_threads The number of instances of geng/gentreeg.
+    /// \param stop_token Token on which the caller can request the run to stop.
+    ///
+    /// **Example**:
+    /// \include multithreaded/inline.cpp
+    template <typename GraphFunction>
+        requires GraphFunctionType<GraphFunction> or GraphViewFunctionType<GraphFunction>
+    void run_inline(GraphFunction callback,
+            const NautyParameters& parameters,
+            size_t nb_threads=std::thread::hardware_concurrency(),
+            std::stop_token stop_token={}) {
+        check_parameters(parameters);
+        const size_t nb_producers{std::max<size_t>(nb_threads, 1)};
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        auto pool{make_containers(
+            containers, nb_producers, 0, 0, max_order_for(parameters),
+            setup_for(parameters, nb_producers, 0)
+        )};
+        std::vector<InlineCallback<GraphFunction>> callbacks;
+        callbacks.reserve(nb_producers);
+        for(auto& container : containers) {
+            callbacks.emplace_back(callback, pool.get());
+            container->set_sink(
+                &InlineCallback<GraphFunction>::call, &callbacks.back()
             );
-            std::sprintf(name_buffer, "Worker %u", static_cast<unsigned>(i+1));
-            rename_thread(workers.back(), name_buffer);
         }
-        auto geng_thread{start_nauty(parameters)};
-        geng_thread.join();
-        for(size_t i{0}; i < nb_workers; ++i)
-            workers.at(i).join();
-        for(size_t idx{1}; idx < nb_workers; ++idx)
-            wrappers.at(0).join(wrappers.at(idx));
-        return static_cast<NautyWorkerWrapper<Callback>&&>(wrappers.at(0)).get();
+        auto stop_link{forward_stop(std::move(stop_token), pool)};
+        auto producer_threads{start_nauty(parameters, containers)};
+        join_all(producer_threads);
+        finish_instrumentation(*pool);
+    }
+
+    /// \brief Start running some callback on all graphs generated by geng/gentreeg.
+    ///
+    /// Non-blocking version of run_async(): the run goes on in the background,
+    /// and several runs can be spawned concurrently (each of them with its
+    /// own producers and workers).
+    ///
+    /// \param callback,parameters,nb_workers,worker_buffer_size,stop_token See run_async().
+    /// \return A handle to wait for the run or to stop it.
+    template <NautyCallbackType GraphFunction>
+    NautyHandle<void> spawn(GraphFunction callback,
+            const NautyParameters& parameters,
+            size_t nb_workers=std::thread::hardware_concurrency(),
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) {
+        return NautyHandle<void>(
+            [nauty=*this, callback=std::move(callback), parameters,
+                    nb_workers, worker_buffer_size](std::stop_token stop) mutable {
+                nauty.run_async(
+                    std::move(callback), parameters, nb_workers, worker_buffer_size,
+                    std::move(stop)
+                );
+            },
+            std::move(stop_token)
+        );
+    }
+
+    /// \brief Start running a callback given by type on all graphs generated by geng/gentreeg.
+    ///
+    /// Non-blocking version of run_async(). The result is given by NautyHandle::get().
+    ///
+    /// **Example**:
+    /// \include multithreaded/spawn.cpp
+    template <GraphRefFunctionType Callback>
+    auto spawn(const NautyParameters& parameters,
+            size_t nb_workers=std::thread::hardware_concurrency(),
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) -> NautyHandle<typename Callback::ResultType> {
+        return NautyHandle<typename Callback::ResultType>(
+            [nauty=*this, parameters, nb_workers, worker_buffer_size](std::stop_token stop) mutable {
+                return nauty.run_async<Callback>(
+                    parameters, nb_workers, worker_buffer_size, std::move(stop)
+                );
+            },
+            std::move(stop_token)
+        );
+    }
+
+    /// \brief Run one shard of an enumeration and save its result in a file.
+    ///
+    /// Only the graphs of class `shard_index/shard_count` are generated
+    /// (see NautyParameters::shard_index), and the result of the shard is
+    /// written to \a path (see serialization::Serializer for the encoding).
+    /// Since shards share no state, they can run in independent processes or
+    /// on different hosts, and be reduced afterwards with merge_shards().
+    ///
+    /// The file is written under a temporary name and renamed once complete,
+    /// so that an interrupted run never leaves a truncated shard behind.
+    ///
+    /// A stopped shard is incomplete: no file is written and an exception
+    /// is thrown instead.
+    ///
+    /// \param parameters The parameters of the whole enumeration.
+    /// \param shard_index,shard_count The shard to run.
+    /// \param path The file in which the result of the shard is saved.
+    /// \param nb_workers,worker_buffer_size,stop_token See run_async().
+    ///
+    /// **Example**:
+    /// \include multithreaded/sharded.cpp
+    template <ShardableCallback Callback>
+    void run_shard(const NautyParameters& parameters,
+            unsigned shard_index, unsigned shard_count,
+            const std::string& path,
+            size_t nb_workers=std::thread::hardware_concurrency(),
+            size_t worker_buffer_size=5'000,
+            std::stop_token stop_token={}) {
+        NautyParameters shard_parameters{parameters};
+        shard_parameters.shard_index = shard_index;
+        shard_parameters.shard_count = shard_count;
+        bool stopped;
+        auto result{run_wrappers<Callback>(
+            shard_parameters, nb_workers, worker_buffer_size, std::move(stop_token), stopped
+        )};
+        if(stopped)
+            throw std::runtime_error("Shard stopped before completion: " + path);
+        const auto tmp_path{path + ".part"};
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            ShardHeader(shard_parameters).write(file);
+            serialization::write(file, result);
+            if(not file.flush())
+                throw std::runtime_error("Unable to write shard file " + tmp_path);
+        }
+        if(std::rename(tmp_path.c_str(), path.c_str()) != 0)
+            throw std::runtime_error("Unable to rename shard file to " + path);
+    }
+
+    /// \brief Merge the results saved by run_shard().
+    ///
+    /// Every shard of the enumeration must be given exactly once.
+    /// Results are folded through `Callback::join()` in the order of \a paths.
+    ///
+    /// \param paths The shard files.
+    /// \return The result of the whole enumeration.
+    ///
+    /// **Example**:
+    /// \include multithreaded/sharded.cpp
+    template <ShardableCallback Callback>
+    static auto merge_shards(const std::vector<std::string>& paths)
+            -> typename Callback::ResultType {
+        std::optional<ShardHeader> reference;
+        std::optional<Callback> merged;
+        std::vector<bool> seen;
+        for(const auto& path : paths) {
+            std::ifstream file(path, std::ios::binary);
+            if(not file)
+                throw std::runtime_error("Unable to open shard file " + path);
+            auto header{ShardHeader::read(file)};
+            if(not reference) {
+                reference = header;
+                seen.assign(header.shard_count, false);
+            } else if(not header.same_enumeration_as(*reference)) {
+                throw std::runtime_error(path + " is a shard of another enumeration");
+            }
+            if(seen[header.shard_index])
+                throw std::runtime_error(path + " is a duplicate shard");
+            seen[header.shard_index] = true;
+            auto result{serialization::read<typename Callback::ResultType>(file)};
+            if(merged)
+                merged->join(Callback(std::move(result)));
+            else
+                merged.emplace(std::move(result));
+        }
+        if(not merged)
+            throw std::runtime_error("No shard to merge");
+        for(size_t idx{0}; idx < seen.size(); ++idx)
+            if(not seen[idx])
+                throw std::runtime_error("Missing shard " + std::to_string(idx));
+        return typename Callback::ResultType(merged->get());
+    }
+
+    /// \brief Iterate lazily over the graphs generated by geng/gentreeg.
+    ///
+    /// `parameters.nb_producers` instances of geng/gentreeg run concurrently
+    /// (in which case the graphs are not given in the order of geng), but no
+    /// worker thread is created. See GraphGenerator.
+    ///
+    /// \param parameters The parameters given to geng/gentreeg.
+    /// \param buffer_size The number of graphs every producer can generate ahead.
+    ///
+    /// **Example**:
+    /// \include iterators/generate.cpp
+    inline GraphGenerator generate(const NautyParameters& parameters,
+            size_t buffer_size=5'000) {
+        check_parameters(parameters);
+        const size_t nb_producers{std::max<unsigned>(parameters.nb_producers, 1)};
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        RunSetup setup;
+        setup.cpus = CpuPlan::make(parameters.placement, nb_producers, 0);
+        auto pool{make_containers(
+            containers, nb_producers, nb_producers, buffer_size, max_order_for(parameters),
+            setup
+        )};
+        auto producers{start_nauty(parameters, containers)};
+        return GraphGenerator(pool, std::move(containers), std::move(producers));
+    }
+
+    /// \brief Iterate lazily over the graphs found in a file.
+    ///
+    /// The file must contain graphs either in the format graph6 or sparse6.
+    /// The graphs are read by the iterating thread. The file is not closed.
+    ///
+    /// \param f The file containing the graphs.
+    /// \param max_graph_size The maximal order of a graph in the file.
+    inline GraphGenerator generate(FILE* f, size_t max_graph_size=100) {
+        return GraphGenerator(f, false, max_graph_size);
     }
 
-    static inline std::unique_ptr<NautyContainer>& get_container() {
+    /// \brief Iterate lazily over the graphs found in a file.
+    ///
+    /// See generate(FILE*, size_t).
+    inline GraphGenerator generate(const std::string& file_path, size_t max_graph_size=100) {
+        FILE* f{fopen(file_path.c_str(), "r")};
+        if(f == NULL)
+            throw std::runtime_error("Unable to open " + file_path);
+        return GraphGenerator(f, true, max_graph_size);
+    }
+
+    /// \brief Get the container fed by the calling producer thread.
+    ///
+    /// Every run owns its containers, and each of its producer threads is
+    /// bound to one of them, so that the output procedures of geng/gentreeg
+    /// feed the run they belong to.
+    static inline NautyContainer* get_container() {
 #ifdef NAUTYPP_DEBUG
-        if(not Nauty::_container)
+        if(Nauty::_bound_container == nullptr)
             throw std::runtime_error("No initialized container");
 #endif
-        return Nauty::_container;
+        return Nauty::_bound_container;
     }
 
+    /// \brief Apply the NautyParameters::prune of the calling producer thread.
+    ///
+    /// Everything is pruned once the run is asked to stop.
+    /// Should only be called by geng.
+    static inline bool _prune(graph* g, int n, int maxn) {
+        if(_bound_container->stop_requested())
+            return true;
+        return _bound_hooks.prune != nullptr
+            and apply_hook(*_bound_hooks.prune, g, n, maxn);
+    }
+
+    /// \brief Apply the NautyParameters::preprune of the calling producer thread.
+    ///
+    /// See _prune().
+    static inline bool _preprune(graph* g, int n, int maxn) {
+        if(_bound_container->stop_requested())
+            return true;
+        return _bound_hooks.preprune != nullptr
+            and apply_hook(*_bound_hooks.preprune, g, n, maxn);
+    }
+
+    /// \brief Thrown through gentreeg to abort a stopped run.
+    ///
+    /// gentreeg has no pruning hook, so its output procedure unwinds it.
+    struct GenerationStopped {};
+
 private:
     //NautyParameters parameters;
 
@@ -506,22 +2104,27 @@ private:
             return "nauty-geng";
     }
 
-    inline std::thread start_reader_thread(
+    inline std::thread start_reader_thread(NautyContainer* container,
             const std::string& file_path,
             size_t max_graph_size) const {
         std::thread ret(
-            [this, max_graph_size](const std::string& path) {
+            [container, max_graph_size](const std::string& path) {
+                Nauty::_bound_container = container;
                 int  n{static_cast<int>(max_graph_size)};
                 int  m{SETWORDSNEEDED(n)};
                 auto G{static_cast<graph*>(ALLOCS(m*n, sizeof(graph)))};
                 FILE* f{fopen(path.c_str(), "r")};
-                if(f == NULL)  // TODO handle error properly
+                if(f == NULL) {  // TODO handle error properly
+                    container->set_over();
+                    FREES(G);
                     return;
+                }
                 boolean directed;
-                while(readgg(f, G, 0, &m, &n, &directed) != nullptr) {
-                    Nauty::get_container()->emplace(G, n, true);
+                while(not container->stop_requested()
+                        and readgg(f, G, 0, &m, &n, &directed) != nullptr) {
+                    container->emplace(G, n);
                 }
-                this->get_container()->set_over();
+                container->set_over();
                 fclose(f);
                 FREES(G);
             },
@@ -530,76 +2133,134 @@ private:
         return ret;
     }
 
-    inline std::thread start_reader_thread(
+    inline std::thread start_reader_thread(NautyContainer* container,
             FILE* f,
             size_t max_graph_size) const {
         std::thread ret(
-            [this, f, max_graph_size]() {
+            [container, f, max_graph_size]() {
+                Nauty::_bound_container = container;
                 int  n{static_cast<int>(max_graph_size)};
                 int  m{SETWORDSNEEDED(n)};
                 auto G{static_cast<graph*>(ALLOCS(m*n, sizeof(graph)))};
                 boolean directed;
-                while(readgg(f, G, 0, &m, &n, &directed) != nullptr) {
-                    Nauty::get_container()->emplace(G, n, true);
+                while(not container->stop_requested()
+                        and readgg(f, G, 0, &m, &n, &directed) != nullptr) {
+                    container->emplace(G, n);
                 }
-                this->get_container()->set_over();
+                container->set_over();
                 FREES(G);
             }
         );
         return ret;
     }
 
-    inline std::thread start_nauty(const NautyParameters& parameters) {
-        std::thread ret{
-            parameters.tree
-            ? start_gentreeg(parameters)
-            : start_geng(parameters)
-        };
-        rename_thread(
-            ret,
-            get_nauty_name(parameters)
-        );
+    /* reject invalid parameters before any thread of the run is started,
+     * so that the exception reaches the caller */
+    static inline void check_parameters(const NautyParameters& parameters) {
+        if(parameters.shard_count == 0 or parameters.shard_index >= parameters.shard_count)
+            throw std::runtime_error("Invalid shard");
+        if(parameters.tree and (parameters.prune or parameters.preprune))
+            throw std::runtime_error("Pruning is only supported by geng");
+    }
+
+    /// Start one geng/gentreeg instance per container.
+    inline std::vector<std::thread> start_nauty(const NautyParameters& parameters,
+            const std::vector<std::unique_ptr<NautyContainer>>& containers) {
+        const auto nb_producers{containers.size()};
+        // producer p of shard s generates the class (s + p*shard_count) / (nb_producers*shard_count)
+        const size_t mod{nb_producers * parameters.shard_count};
+        std::vector<std::thread> ret;
+        ret.reserve(nb_producers);
+        char name_buffer[16];
+        for(size_t p{0}; p < nb_producers; ++p) {
+            auto container{containers.at(p).get()};
+            const size_t res{parameters.shard_index + p*parameters.shard_count};
+            if(nb_producers == 1)
+                std::strcpy(name_buffer, get_nauty_name(parameters));
+            else
+                std::snprintf(
+                    name_buffer, sizeof(name_buffer), "%s-%u",
+                    get_nauty_name(parameters), static_cast<unsigned>(p+1)
+                );
+            if(container->_track != nullptr)
+                container->_track->set_name(name_buffer);
+            ret.push_back(
+                parameters.tree
+                ? start_gentreeg(parameters, container, res, mod)
+                : start_geng(parameters, container, res, mod)
+            );
+            rename_thread(ret.back(), name_buffer);
+            pin_thread(ret.back(), container->_cpu);
+        }
         return ret;
     }
 
-    inline std::thread start_gentreeg(const NautyParameters& parameters) {
-        strcpy(params[0], "gentreeg");
-        std::sprintf(
-            params[1],
-            "-D%d%s",
-            parameters.max_deg,
+    /// Arguments given to the main function of geng/gentreeg.
+    struct NautyArgv {
+        static inline constexpr auto ARGC{4};
+        static inline constexpr auto BUFFER_SIZE{64};
+        char  params[ARGC][BUFFER_SIZE];
+        char* argv[ARGC];
+
+        NautyArgv(const char* name, size_t res, size_t mod) {
+            for(auto i{0}; i < ARGC; ++i)
+                argv[i] = params[i];
+            std::strcpy(params[0], name);
+            std::sprintf(
+                params[3], "%u/%u",
+                static_cast<unsigned>(res), static_cast<unsigned>(mod)
+            );
+        }
+    };
+
+    inline std::thread start_gentreeg(const NautyParameters& parameters,
+            NautyContainer* container, size_t res, size_t mod) {
+        std::thread t(
+            [container, res, mod](NautyParameters parameters) {
+                Nauty::_bound_container = container;
+                NautyArgv args("gentreeg", res, mod);
+                std::sprintf(
+                    args.params[1],
+                    "-D%d%s",
+                    parameters.max_deg,
 #ifdef NAUTYPP_DEBUG
-            ""
+                    ""
 #else
-            "q"
+                    "q"
 #endif
-        );
-        std::sprintf(
-            params[2], "%d", parameters.V
-        );
-        for(auto i{0}; i < Nauty::GENG_ARGC; ++i)
-            geng_argv[i] = params[i];
-        std::thread t(
-            [this]() {
-                _gentreeg_main(Nauty::GENG_ARGC, geng_argv);
-                this->set_container_over();
-            }
+                );
+                std::sprintf(
+                    args.params[2], "%d", parameters.V
+                );
+                try {
+                    _gentreeg_main(NautyArgv::ARGC, args.argv);
+                } catch(const GenerationStopped&) {
+                }
+                container->set_over();
+            },
+            parameters
         );
         return t;
     }
 
-    inline std::thread start_geng(const NautyParameters& parameters) {
-        strcpy(params[0], "geng");
-        for(auto i{0}; i < Nauty::GENG_ARGC; ++i)
-            geng_argv[i] = params[i];
+    inline std::thread start_geng(const NautyParameters& parameters,
+            NautyContainer* container, size_t res, size_t mod) {
         std::thread t(
-            [this, &parameters]() {
+            [container, res, mod](NautyParameters parameters) {
+                Nauty::_bound_container = container;
+                auto view{Graph::make_view()};
+                Nauty::_bound_hooks = {
+                    parameters.prune    ? &parameters.prune    : nullptr,
+                    parameters.preprune ? &parameters.preprune : nullptr,
+                    &view
+                };
+                NautyArgv args("geng", res, mod);
                 int min_deg, max_deg;
-                for(int V{parameters.V}; V <= parameters.Vmax; ++V) {
+                for(int V{parameters.V}; V <= parameters.Vmax and not container->stop_requested(); ++V) {
                     min_deg = std::min(parameters.min_deg, V-1);
                     max_deg = std::min(parameters.max_deg, V-1);
                     std::sprintf(
-                        params[1],
+                        args.params[1],
                         "-%s%s%s%s%s%s%s%s%s%s%sd%dD%d%s",
                         parameters.connected     ? "c" : "",
                         parameters.biconnected   ? "C" : "",
@@ -620,55 +2281,265 @@ private:
                         "q"
 #endif
                     );
-                    std::sprintf(this->geng_argv[2], "%d", V);
-                    _geng_main(Nauty::GENG_ARGC, this->geng_argv);
+                    std::sprintf(args.params[2], "%d", V);
+                    _geng_main(NautyArgv::ARGC, args.argv);
                 }
-                this->set_container_over();
-            }
+                Nauty::_bound_hooks = {};
+                container->set_over();
+            },
+            parameters
         );
         return t;
     }
 
-    static inline constexpr auto GENG_ARGV_BUFFER_SIZE{64};
-    static inline constexpr auto GENG_ARGC{3};
-    char params[Nauty::GENG_ARGC][Nauty::GENG_ARGV_BUFFER_SIZE];
-    char* geng_argv[Nauty::GENG_ARGC];
+    static inline size_t nb_producers_for(const NautyParameters& parameters,
+            size_t nb_workers) {
+        return std::clamp<size_t>(parameters.nb_producers, 1, std::max<size_t>(nb_workers, 1));
+    }
+
+    /// Largest number of vertices of the graphs generated with \a parameters.
+    static inline size_t max_order_for(const NautyParameters& parameters) {
+        if(parameters.tree)
+            return static_cast<size_t>(std::max(parameters.V, 1));
+        return static_cast<size_t>(std::max({parameters.V, parameters.Vmax, 1}));
+    }
+
+    /* everything a run needs besides its callback and its buffers */
+    struct RunSetup {
+        PipelineStatistics* statistics;
+        PipelineTrace*      trace;
+        CpuPlan             cpus;
+
+        RunSetup(PipelineStatistics* statistics=nullptr, PipelineTrace* trace=nullptr,
+                CpuPlan cpus={}):
+                statistics{statistics}, trace{trace}, cpus{std::move(cpus)} {
+        }
+    };
+
+    static inline RunSetup setup_for(const NautyParameters& parameters,
+            size_t nb_producers, size_t nb_workers) {
+        return RunSetup{
+            parameters.statistics, parameters.trace,
+            CpuPlan::make(parameters.placement, nb_producers, nb_workers)
+        };
+    }
+
+    /// \brief Create the containers of the producers and the buffers of the workers.
+    ///
+    /// Worker `i` is fed by producer `i % nb_producers`.
+    /// \param containers Where to put the containers (one per producer).
+    /// \param max_order The largest number of vertices of a graph of the run.
+    /// \param setup The instrumentation and the placement of the run.
+    /// \return The pool of all the buffers, the i-th one belonging to worker i.
+    static std::shared_ptr<NautyBufferPool> make_containers(
+            std::vector<std::unique_ptr<NautyContainer>>& containers,
+            size_t nb_producers, size_t nb_workers, size_t buffer_size,
+            size_t max_order, const RunSetup& setup={}) {
+        auto statistics{setup.statistics};
+        auto trace{setup.trace};
+        auto pool{std::make_shared<NautyBufferPool>(statistics, trace)};
+        if(statistics != nullptr)
+            statistics->start(nb_producers, nb_workers);
+        if(trace != nullptr)
+            trace->start(nb_producers, nb_workers);
+        for(size_t i{0}; i < nb_producers; ++i) {
+            containers.emplace_back(new NautyContainer(pool));
+            containers.back()->_cpu = setup.cpus.producer(i);
+            containers.back()->instrument(
+                statistics == nullptr ? nullptr : &statistics->producer(i),
+                trace == nullptr ? nullptr : &trace->producer(i)
+            );
+        }
+        for(size_t i{0}; i < nb_workers; ++i)
+            containers.at(i % nb_producers)->add_new_buffer(
+                buffer_size, max_order, setup.cpus.buffer(i)
+            );
+        return pool;
+    }
+
+    static thread_local NautyContainer* _bound_container;
+
+    /* pruning predicates of the geng instance running in the calling thread */
+    struct PruningHooks {
+        const PruningPredicate* prune{nullptr};
+        const PruningPredicate* preprune{nullptr};
+        Graph* view{nullptr};
+    };
+    static thread_local PruningHooks _bound_hooks;
+
+    static inline bool apply_hook(const PruningPredicate& predicate,
+            graph* g, int n, int maxn) {
+        _bound_hooks.view->rebind(g, static_cast<size_t>(n));
+        return predicate(*_bound_hooks.view, static_cast<size_t>(maxn));
+    }
+
+    /* forward a stop requested on stop_token to the run using pool */
+    static inline auto forward_stop(std::stop_token stop_token,
+            std::shared_ptr<NautyBufferPool> pool) {
+        return std::stop_callback(
+            std::move(stop_token),
+            [pool=std::move(pool)]() { pool->request_stop(); }
+        );
+    }
+
+    /// \brief Reduce the results of the workers in a binary tree.
+    ///
+    /// Called by worker \a idx once its run is over: it joins the result of
+    /// worker `idx + 2^k` (itself already reduced with its own subtree) as
+    /// soon as it is available, for every `k` such that `idx` is a multiple
+    /// of `2^(k+1)`. Hence merges start while slower workers are still
+    /// running, the reduction has logarithmic depth, and `wrappers[0]` ends
+    /// up with the result of the whole run.
+    /// Results are always joined with the next ones (in the order of the
+    /// workers), so `Callback::join` only needs to be associative.
+    template <typename Wrapper>
+    static void tree_reduce(std::vector<Wrapper>& wrappers,
+            std::atomic_bool* reduced, size_t idx) {
+        for(size_t step{1}; step < wrappers.size() and (idx & step) == 0; step <<= 1) {
+            const auto partner{idx + step};
+            if(partner >= wrappers.size())
+                continue;
+            reduced[partner].wait(false, std::memory_order_acquire);
+            wrappers[idx].join(wrappers[partner]);
+        }
+        reduced[idx].store(true, std::memory_order_release);
+        reduced[idx].notify_one();
+    }
+
+    static inline void join_all(std::vector<std::thread>& threads) {
+        for(auto& thread : threads)
+            thread.join();
+    }
 
-    static void reset_container() {
-        Nauty::_container.reset(new NautyContainer());
+    /* instrument worker idx of the run using pool, whose thread is called name */
+    template <typename Worker>
+    static inline void instrument_worker(Worker& worker, const NautyBufferPool& pool,
+            size_t idx, const char* name) {
+        auto statistics{pool.statistics()};
+        auto trace{pool.trace()};
+        if(trace != nullptr)
+            trace->worker(idx).set_name(name);
+        worker.instrument(
+            statistics == nullptr ? nullptr : &statistics->worker(idx),
+            trace == nullptr ? nullptr : &trace->worker(idx)
+        );
     }
 
-    static std::unique_ptr<NautyContainer> _container;
-    inline void set_container_over() {
-        Nauty::get_container()->set_over();
+    /* callback of a producer thread of run_inline() */
+    template <typename GraphFunction>
+    struct InlineCallback {
+        GraphFunction    callback;
+        NautyBufferPool* pool;
+        Graph            view;
+
+        InlineCallback(const GraphFunction& f, NautyBufferPool* pool):
+                callback(f), pool{pool}, view{Graph::make_view()} {
+        }
+
+        static void call(void* self, graph* g, size_t n) {
+            auto& state{*static_cast<InlineCallback*>(self)};
+            if constexpr(GraphViewFunctionType<GraphFunction>) {
+                GraphView view(g, n);
+                state.invoke(view);
+            } else {
+                state.view.rebind(g, n);
+                state.invoke(state.view);
+            }
+        }
+
+        template <typename Arg>
+        inline void invoke(Arg& G) {
+            if constexpr(std::is_same_v<std::invoke_result_t<GraphFunction&, Arg&>, CallbackStatus>) {
+                if(callback(G) == CallbackStatus::STOP)
+                    pool->request_stop();
+            } else {
+                callback(G);
+            }
+        }
+    };
+
+    /* end the statistics and the trace of the run using pool (if any) */
+    static inline void finish_instrumentation(const NautyBufferPool& pool) {
+        if(auto statistics{pool.statistics()}; statistics != nullptr)
+            statistics->finish();
+        if(auto trace{pool.trace()}; trace != nullptr)
+            trace->finish();
     }
 
-    template <GraphFunctionType GraphFunction>
-    auto make_workers(GraphFunction callback,
-            size_t nb_workers, size_t worker_buffer_size) {
-        Nauty::reset_container();
+    /* create the containers of the run in containers, and start the workers */
+    template <NautyCallbackType GraphFunction>
+    auto make_workers(std::vector<std::unique_ptr<NautyContainer>>& containers,
+            GraphFunction callback,
+            size_t nb_workers, size_t worker_buffer_size, size_t nb_producers,
+            size_t max_order, const RunSetup& setup={}) {
+        auto pool{make_containers(
+            containers, nb_producers, nb_workers, worker_buffer_size, max_order, setup
+        )};
+        typedef typename NautyWorkerFor<GraphFunction>::type Worker;
         std::vector<std::thread> worker_threads;
-        std::vector<NautyWorker<GraphFunction>> workers;
+        std::vector<Worker> workers;
         worker_threads.reserve(nb_workers);
         workers.reserve(nb_workers);
-        static char name_buffer[32];
+        char name_buffer[32];
         for(size_t i{0}; i < nb_workers; ++i) {
-            auto worker_buffer{
-                Nauty::_container->add_new_buffer(worker_buffer_size)
-            };
-            workers.emplace_back(worker_buffer, callback);
+            std::sprintf(name_buffer, "Worker %u", static_cast<unsigned>(i+1));
+            workers.emplace_back(pool->buffer(i), pool, callback);
+            instrument_worker(workers.back(), *pool, i, name_buffer);
             worker_threads.emplace_back(
-                &NautyWorker<GraphFunction>::run,
+                &Worker::run,
                 &workers.back()
             );
-            std::sprintf(name_buffer, "Worker %u", static_cast<unsigned>(i+1));
             rename_thread(worker_threads.back(), name_buffer);
+            pin_thread(worker_threads.back(), setup.cpus.worker(i));
         }
-        return std::make_pair(
+        return std::make_tuple(
             std::move(worker_threads),
-            std::move(workers)
+            std::move(workers),
+            std::move(pool)
         );
     }
+
+    /* run_async() for callbacks given by type; stopped tells whether the run ended early */
+    template <GraphRefFunctionType Callback>
+    auto run_wrappers(const NautyParameters& parameters,
+            size_t nb_workers, size_t worker_buffer_size,
+            std::stop_token stop_token, bool& stopped) -> typename Callback::ResultType {
+        check_parameters(parameters);
+        std::vector<std::unique_ptr<NautyContainer>> containers;
+        const auto nb_producers{nb_producers_for(parameters, nb_workers)};
+        const auto setup{setup_for(parameters, nb_producers, nb_workers)};
+        auto pool{make_containers(
+            containers, nb_producers, nb_workers,
+            worker_buffer_size, max_order_for(parameters), setup
+        )};
+        auto stop_link{forward_stop(std::move(stop_token), pool)};
+        std::vector<NautyWorkerWrapper<Callback>> wrappers;
+        std::vector<std::thread> workers;
+        std::unique_ptr<std::atomic_bool[]> reduced{new std::atomic_bool[nb_workers]{}};
+        wrappers.reserve(nb_workers);
+        workers.reserve(nb_workers);
+        char name_buffer[32];
+        for(size_t i{0}; i < nb_workers; ++i) {
+            std::sprintf(name_buffer, "Worker %u", static_cast<unsigned>(i+1));
+            wrappers.emplace_back(pool->buffer(i), pool);
+            instrument_worker(wrappers.back(), *pool, i, name_buffer);
+        }
+        for(size_t i{0}; i < nb_workers; ++i) {
+            workers.emplace_back([&wrappers, &reduced, i]() {
+                wrappers[i].run();
+                tree_reduce(wrappers, reduced.get(), i);
+            });
+            std::sprintf(name_buffer, "Worker %u", static_cast<unsigned>(i+1));
+            rename_thread(workers.back(), name_buffer);
+            pin_thread(workers.back(), setup.cpus.worker(i));
+        }
+        auto producer_threads{start_nauty(parameters, containers)};
+        join_all(producer_threads);
+        join_all(workers);
+        finish_instrumentation(*pool);
+        stopped = pool->stop_requested();
+        return static_cast<NautyWorkerWrapper<Callback>&&>(wrappers.at(0)).get();
+    }
 };
 
 }  // namespace nautypp
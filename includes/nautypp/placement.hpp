@@ -0,0 +1,212 @@
+#ifndef NAUTYPP_PLACEMENT_HPP
+#define NAUTYPP_PLACEMENT_HPP
+
+/// \file placement.hpp
+/// \brief Placement of the threads of a run on the CPUs and NUMA nodes.
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <nautypp/aliases.hpp>
+
+namespace nautypp {
+
+/// \brief Placement of the threads of a run (see NautyParameters::placement).
+///
+/// Pinned threads are not migrated by the scheduler, and the buffer of a
+/// pinned worker can be allocated on the NUMA node of its CPU, so that on
+/// multi-socket machines every producer and the workers it feeds exchange
+/// graphs without crossing sockets.
+///
+/// Only supported on Linux (ignored elsewhere).
+///
+/// **Example**:
+/// \include multithreaded/placement.cpp
+struct ThreadPlacement {
+    /// Pin the producers and the workers to CPUs. Unless their CPUs are
+    /// given explicitly, producers are spread over the NUMA nodes, and every
+    /// worker runs on the node of the producer feeding it.
+    bool pin = false;
+
+    /// CPUs of the producers: producer p runs on `producer_cpus[p % size]`
+    /// (placed automatically if empty).
+    std::vector<int> producer_cpus{};
+
+    /// CPUs of the workers: worker i runs on `worker_cpus[i % size]`
+    /// (placed automatically if empty).
+    std::vector<int> worker_cpus{};
+
+    /// Allocate the buffer of every pinned worker on the NUMA node of its CPU.
+    bool local_buffers = true;
+};
+
+namespace numa {
+
+/// \brief Parse a list of CPUs in the format of the Linux sysfs (e.g. `0-3,8,10-11`).
+static inline std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> ret;
+    std::stringstream ss(list);
+    std::string range;
+    while(std::getline(ss, range, ',')) {
+        if(range.empty() or range == "\n")
+            continue;
+        const auto dash{range.find('-')};
+        const int first{std::stoi(range.substr(0, dash))};
+        const int last{dash == std::string::npos ? first : std::stoi(range.substr(dash+1))};
+        for(int cpu{first}; cpu <= last; ++cpu)
+            ret.push_back(cpu);
+    }
+    return ret;
+}
+
+/// \brief CPUs the calling process is allowed to run on.
+static inline std::vector<int> allowed_cpus() {
+    std::vector<int> ret;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for(int cpu{0}; cpu < CPU_SETSIZE; ++cpu)
+            if(CPU_ISSET(cpu, &set))
+                ret.push_back(cpu);
+        return ret;
+    }
+#endif
+    for(unsigned cpu{0}; cpu < std::max(std::thread::hardware_concurrency(), 1u); ++cpu)
+        ret.push_back(static_cast<int>(cpu));
+    return ret;
+}
+
+/// \brief CPUs of every NUMA node, restricted to allowed_cpus().
+///
+/// Nodes without any allowed CPU are left out. Machines without NUMA
+/// information are seen as a single node.
+static inline std::vector<std::vector<int>> nodes() {
+    const auto allowed{allowed_cpus()};
+    std::vector<std::vector<int>> ret;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if(online and std::getline(online, list)) {
+        for(auto node : parse_cpu_list(list)) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            std::string cpus;
+            if(not file or not std::getline(file, cpus))
+                continue;
+            std::vector<int> node_cpus;
+            for(auto cpu : parse_cpu_list(cpus))
+                if(std::find(allowed.begin(), allowed.end(), cpu) != allowed.end())
+                    node_cpus.push_back(cpu);
+            if(not node_cpus.empty())
+                ret.push_back(std::move(node_cpus));
+        }
+    }
+    if(ret.empty())
+        ret.push_back(allowed);
+    return ret;
+}
+
+}  // namespace numa
+
+/// \brief CPU of every thread of a run (-1 for the threads that are not pinned).
+struct CpuPlan {
+    std::vector<int> producers;
+    std::vector<int> workers;
+    bool local_buffers{false};
+
+    /// \brief Place \a nb_producers producers and \a nb_workers workers,
+    /// worker i being fed by producer `i % nb_producers`.
+    ///
+    /// Producer p gets the first free CPU of node `p % nb_nodes`, and the
+    /// workers it feeds the next ones of the same node (wrapping around the
+    /// CPUs of the node if there are more threads than CPUs).
+    static inline CpuPlan make(const ThreadPlacement& placement,
+            size_t nb_producers, size_t nb_workers) {
+        CpuPlan ret;
+        ret.producers.assign(nb_producers, -1);
+        ret.workers.assign(nb_workers, -1);
+        if(not placement.pin)
+            return ret;
+        ret.local_buffers = placement.local_buffers;
+        std::vector<std::vector<int>> nodes;
+        if(placement.producer_cpus.empty() or placement.worker_cpus.empty())
+            nodes = numa::nodes();
+        std::vector<size_t> next(nodes.size(), 0);
+        auto take{[&nodes, &next](size_t node) {
+            const auto& cpus{nodes[node]};
+            return cpus[next[node]++ % cpus.size()];
+        }};
+        for(size_t p{0}; p < nb_producers; ++p)
+            ret.producers[p] = placement.producer_cpus.empty()
+                ? take(p % nodes.size())
+                : placement.producer_cpus[p % placement.producer_cpus.size()];
+        for(size_t i{0}; i < nb_workers; ++i)
+            ret.workers[i] = placement.worker_cpus.empty()
+                ? take((i % nb_producers) % nodes.size())
+                : placement.worker_cpus[i % placement.worker_cpus.size()];
+        return ret;
+    }
+
+    /// \brief CPU of producer \a p (-1 if not pinned).
+    inline int producer(size_t p) const {
+        return p < producers.size() ? producers[p] : -1;
+    }
+
+    /// \brief CPU of worker \a i (-1 if not pinned).
+    inline int worker(size_t i) const {
+        return i < workers.size() ? workers[i] : -1;
+    }
+
+    /// \brief CPU on which the buffer of worker \a i must be allocated (-1 if anywhere).
+    inline int buffer(size_t i) const {
+        return local_buffers ? worker(i) : -1;
+    }
+};
+
+/// \brief Restrict \a thread to run on \a cpu (no-op if \a cpu is negative).
+///
+/// \return false if the thread could not be pinned.
+static inline bool pin_thread(std::thread& thread, int cpu) {
+    if(cpu < 0)
+        return true;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) == 0;
+#else
+    (void)(thread);
+    return false;
+#endif
+}
+
+/// \brief Call \a f in a thread running on \a cpu, and wait for it.
+///
+/// Memory first written by \a f is allocated on the NUMA node of \a cpu.
+template <typename Function>
+static inline void run_on_cpu(int cpu, Function&& f) {
+    std::thread thread([&f, cpu]() {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)(cpu);
+#endif
+        f();
+    });
+    thread.join();
+}
+
+}  // namespace nautypp
+
+#endif
@@ -1,129 +1,131 @@
 #ifndef NAUTYPP_PROPERTIES_HPP
 #define NAUTYPP_PROPERTIES_HPP
 
-#include <utility>
+/// \file properties.hpp
+/// \brief Cache of the properties of a Graph computed from its rows.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 #include <nautypp/aliases.hpp>
 #include <nautypp/cliquer.hpp>
+#include <nautypp/view.hpp>
 
 namespace nautypp {
-class Graph;
 
-template <typename T>
-class ComputableProperty {
+/// \brief Degrees, number of edges and cliquer representation of a graph,
+/// computed on demand from its rows and kept until they are invalidated.
+///
+/// The cache is flat: a bitmask telling which degrees are up to date, the
+/// packed degrees (4 bytes per vertex) and the number of edges. It does not
+/// point to its graph (the rows are given to every query), hence moving a
+/// Graph moves its cache as is.
+class PropertyCache {
 public:
-    ComputableProperty() = delete;
-    ComputableProperty(const Graph& G):
-            graph{std::addressof(G)}, computed{false}, value{} {
-    }
-    ComputableProperty(const ComputableProperty&) = delete;
-    ComputableProperty(ComputableProperty&& other):
-            graph{other.graph}, computed{other.computed},
-            value{std::move(other.value)} {
-    }
+    PropertyCache() = default;
+    PropertyCache(const PropertyCache&) = delete;
+    PropertyCache(PropertyCache&&) = default;
 
-    ComputableProperty& operator=(const ComputableProperty&) = delete;
-    ComputableProperty& operator=(ComputableProperty&& other) {
-        graph = other.graph;
-        computed = other.computed;
-        value = std::move(other.value);
-        return *this;
-    }
+    PropertyCache& operator=(const PropertyCache&) = delete;
+    PropertyCache& operator=(PropertyCache&&) = default;
 
-    virtual ~ComputableProperty() = default;
-    inline void set_stale() {
-        computed = false;
+    /// \brief Degree of the vertex \a v of \a G.
+    inline size_t degree(const GraphView& G, Vertex v) {
+        if(not has_degree(v)) [[unlikely]]
+            return compute_degree(G, v);
+        return _degrees[v];
     }
 
-    inline T get() {
-        if(not computed) {
-            compute();
-            computed = true;
+    /// \brief Number of edges of \a G.
+    inline size_t nb_edges(const GraphView& G) {
+        if(not _has_nb_edges) {
+            _nb_edges = G.E();
+            _has_nb_edges = true;
         }
-        return value;
+        return _nb_edges;
     }
 
-    inline operator bool() const {
-        return computed;
+    /// \brief \a G in the format of cliquer (owned by the cache).
+    inline cliquer_graph_t* cliquer(const GraphView& G) {
+        if(not _has_cliquer) {
+            _cliquer.reset(G.to_cliquer());
+            _has_cliquer = true;
+        }
+        return _cliquer.get();
     }
-protected:
-    friend class Graph;
 
-    const Graph* graph;
-    bool computed=false;
-    T value;
-    virtual void compute() = 0;
-
-    inline void reset_graph(const Graph* new_graph) {
-        graph = new_graph;
+    /// \brief Account for a new edge between \a v and \a w (in constant time).
+    inline void edge_added(Vertex v, Vertex w) {
+        update_edge(v, w, +1);
     }
-};
 
-class EdgeProperty final : public ComputableProperty<size_t> {
-public:
-    EdgeProperty(const Graph& G): ComputableProperty(G) {
-    }
-    EdgeProperty(EdgeProperty&& other):
-            ComputableProperty<size_t>(std::move(other)) {
-    }
-    EdgeProperty& operator=(EdgeProperty&& other) {
-        ComputableProperty<size_t>::operator=(std::move(other));
-        return *this;
+    /// \brief Account for the removal of the edge between \a v and \a w (in constant time).
+    inline void edge_removed(Vertex v, Vertex w) {
+        update_edge(v, w, -1);
     }
-    virtual ~EdgeProperty() = default;
-protected:
-    virtual inline void compute() override final;
-};
 
-class DegreeProperty final : public ComputableProperty<size_t> {
-public:
-    DegreeProperty(const Graph& G, Vertex vertex):
-            ComputableProperty<size_t>(G), v{vertex} {
-    }
-    DegreeProperty(DegreeProperty&& other):
-            ComputableProperty<size_t>(std::move(other)), v{other.v} {
+    /// \brief Mark the degree of \a v and every global property as stale.
+    inline void invalidate(Vertex v) {
+        if(v / WORDSIZE < _fresh.size())
+            _fresh[v / WORDSIZE] &= ~bit(v);
+        _has_nb_edges = false;
+        _has_cliquer = false;
     }
-    DegreeProperty(const DegreeProperty&) = delete;
 
-    DegreeProperty& operator=(const DegreeProperty&) = delete;
-    DegreeProperty& operator=(DegreeProperty&& other) {
-        ComputableProperty<size_t>::operator=(std::move(other));
-        v = other.v;
-        return *this;
+    /// \brief Mark every property as stale (without freeing anything).
+    inline void invalidate() {
+        std::fill(_fresh.begin(), _fresh.end(), setword{0});
+        _has_nb_edges = false;
+        _has_cliquer = false;
     }
-    ~DegreeProperty() = default;
-protected:
-    Vertex v;
+private:
+    struct CliquerDeleter {
+        inline void operator()(cliquer_graph_t* G) const {
+            graph_free(G);
+        }
+    };
 
-    virtual inline void compute() override final;
-};
+    std::vector<setword>                              _fresh;    // bit v set iff _degrees[v] is up to date
+    std::vector<std::uint32_t>                        _degrees;
+    std::unique_ptr<cliquer_graph_t, CliquerDeleter>  _cliquer;
+    size_t                                            _nb_edges{0};
+    bool                                              _has_nb_edges{false};
+    bool                                              _has_cliquer{false};
 
-class _CliquerGraphProperty final : public ComputableProperty<cliquer_graph_t*> {
-public:
-    _CliquerGraphProperty(const Graph& G):
-            ComputableProperty<cliquer_graph_t*>(G) {
-    }
-    _CliquerGraphProperty(_CliquerGraphProperty&& other):
-            ComputableProperty<cliquer_graph_t*>(std::move(other)) {
+    static inline setword bit(Vertex v) {
+        return setword{1} << (v % WORDSIZE);
     }
-    _CliquerGraphProperty(const _CliquerGraphProperty&) = delete;
 
-    _CliquerGraphProperty& operator=(const _CliquerGraphProperty&) = delete;
-    inline _CliquerGraphProperty& operator=(_CliquerGraphProperty&& other) {
-        ComputableProperty<cliquer_graph_t*>::operator=(std::move(other));
-        return *this;
+    inline bool has_degree(Vertex v) const {
+        return v / WORDSIZE < _fresh.size() and (_fresh[v / WORDSIZE] & bit(v)) != 0;
     }
-    ~_CliquerGraphProperty() {
-        clear();
-    }
-protected:
-    virtual inline void compute() override final;
 
-    inline void clear() {
-        if(value != nullptr) {
-            graph_free(value);
-            value = nullptr;
+    /* the degrees and the number of edges that are known are kept up to date,
+     * but the cliquer graph is rebuilt on demand */
+    inline void update_edge(Vertex v, Vertex w, int delta) {
+        if(v == w) {  // a loop counts once in the row, but E is half the sum of the degrees
+            invalidate(v);
+            return;
+        }
+        if(has_degree(v))
+            _degrees[v] += delta;
+        if(has_degree(w))
+            _degrees[w] += delta;
+        _nb_edges += delta;  // only read if _has_nb_edges
+        _has_cliquer = false;
+    }
+
+    /* the arrays are only allocated once a degree is asked for, and never shrink */
+    inline size_t compute_degree(const GraphView& G, Vertex v) {
+        if(_degrees.size() < G.V()) {
+            _degrees.resize(G.V());
+            _fresh.resize((G.V() + WORDSIZE-1) / WORDSIZE, setword{0});
         }
+        _degrees[v] = static_cast<std::uint32_t>(G.degree(v));
+        _fresh[v / WORDSIZE] |= bit(v);
+        return _degrees[v];
     }
 };
 
@@ -0,0 +1,324 @@
+#ifndef NAUTYPP_REDUCERS_HPP
+#define NAUTYPP_REDUCERS_HPP
+
+/// \file reducers.hpp
+/// \brief Per-thread accumulators for callbacks given by value.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <nautypp/aliases.hpp>
+
+namespace nautypp {
+/// \namespace nautypp::reducers
+/// \brief Accumulators that can be shared by all the workers of a run.
+///
+/// A reducer holds one shard per thread, each on its own cache lines: a
+/// callback updates the shard of the calling thread without any atomic
+/// operation nor contention, and the shards are merged when the result is
+/// read. Hence a lambda can capture a reducer by reference instead of
+/// updating a `std::atomic` shared by every worker.
+///
+/// The result must only be read once no thread updates the reducer anymore
+/// (e.g. after Nauty::run_async() returned).
+///
+/// **Example**:
+/// \include multithreaded/reducers.cpp
+namespace reducers {
+
+/// \brief Small identifier of the calling thread.
+///
+/// Identifiers are recycled when threads exit, so that they stay smaller
+/// than the number of threads alive at the same time.
+class ThreadSlot {
+public:
+    static inline size_t get() {
+        thread_local ThreadSlot slot;
+        return slot._idx;
+    }
+private:
+    size_t _idx;
+
+    ThreadSlot(): _idx{acquire()} {
+    }
+
+    ~ThreadSlot() {
+        release(_idx);
+    }
+
+    struct Registry {
+        std::mutex          mutex;
+        std::vector<size_t> free;
+        size_t              next{0};
+    };
+
+    static inline Registry& registry() {
+        static Registry ret;
+        return ret;
+    }
+
+    static inline size_t acquire() {
+        auto& reg{registry()};
+        std::lock_guard lock(reg.mutex);
+        if(reg.free.empty())
+            return reg.next++;
+        // smallest free identifier, so that shards are reused first
+        auto it{std::min_element(reg.free.begin(), reg.free.end())};
+        auto ret{*it};
+        *it = reg.free.back();
+        reg.free.pop_back();
+        return ret;
+    }
+
+    static inline void release(size_t idx) {
+        auto& reg{registry()};
+        std::lock_guard lock(reg.mutex);
+        reg.free.push_back(idx);
+    }
+};
+
+/// \brief One \a Shard per thread, allocated on first use.
+///
+/// Shards are allocated by chunks that never move, so that a thread can
+/// get its own shard while other threads allocate theirs.
+template <typename Shard>
+class Sharded {
+public:
+    /// Number of shards per chunk.
+    static constexpr size_t CHUNK_SIZE{64};
+    /// Maximal number of chunks (hence of threads using a same reducer at once).
+    static constexpr size_t MAX_CHUNKS{64};
+
+    Sharded() = default;
+    Sharded(const Sharded&) = delete;
+    Sharded& operator=(const Sharded&) = delete;
+
+    ~Sharded() {
+        for(auto& chunk : _chunks)
+            delete chunk.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Shard of the calling thread.
+    inline Shard& local() {
+        const auto idx{ThreadSlot::get()};
+        if(idx >= CHUNK_SIZE * MAX_CHUNKS)
+            throw std::runtime_error("Too many threads for a reducer");
+        auto& chunk{_chunks[idx / CHUNK_SIZE]};
+        auto ptr{chunk.load(std::memory_order_acquire)};
+        if(ptr == nullptr) [[unlikely]] {
+            auto fresh{new Chunk};
+            if(chunk.compare_exchange_strong(ptr, fresh, std::memory_order_acq_rel))
+                ptr = fresh;
+            else
+                delete fresh;  // allocated by another thread in the meantime
+        }
+        return ptr->shards[idx % CHUNK_SIZE].value;
+    }
+
+    /// \brief Apply \a f to every shard used so far.
+    template <typename Function>
+    inline void for_each(Function&& f) const {
+        for(const auto& chunk : _chunks)
+            if(auto ptr{chunk.load(std::memory_order_acquire)}; ptr != nullptr)
+                for(const auto& shard : ptr->shards)
+                    if(shard.value.used())
+                        f(shard.value);
+    }
+
+    /// \brief Reset every shard.
+    inline void clear() {
+        for(auto& chunk : _chunks)
+            if(auto ptr{chunk.load(std::memory_order_acquire)}; ptr != nullptr)
+                for(auto& shard : ptr->shards)
+                    shard.value = Shard();
+    }
+private:
+    struct alignas(CACHE_LINE_SIZE) Padded {
+        Shard value;
+    };
+    struct Chunk {
+        std::array<Padded, CHUNK_SIZE> shards;
+    };
+    std::array<std::atomic<Chunk*>, MAX_CHUNKS> _chunks{};
+};
+
+/// \brief Sum of values.
+template <typename T=size_t>
+class Counter {
+public:
+    inline Counter& operator+=(const T& x) {
+        auto& shard{_shards.local()};
+        shard.value += x;
+        shard.touched = true;
+        return *this;
+    }
+
+    inline Counter& operator++() {
+        return *this += T{1};
+    }
+
+    inline T get() const {
+        T ret{};
+        _shards.for_each([&ret](const Shard& shard) { ret += shard.value; });
+        return ret;
+    }
+
+    inline operator T() const {
+        return get();
+    }
+
+    inline void clear() {
+        _shards.clear();
+    }
+private:
+    struct Shard {
+        T    value{};
+        bool touched{false};
+        inline bool used() const {
+            return touched;
+        }
+    };
+    Sharded<Shard> _shards;
+};
+
+/// \brief Number of occurrences of small non-negative integers
+/// (e.g. degrees, numbers of edges).
+template <typename T=size_t>
+class Histogram {
+public:
+    inline void add(size_t key, const T& count=T{1}) {
+        auto& bins{_shards.local().bins};
+        if(key >= bins.size())
+            bins.resize(key+1, T{});
+        bins[key] += count;
+    }
+
+    /// \return The count of every key, up to the largest key added.
+    inline std::vector<T> get() const {
+        std::vector<T> ret;
+        _shards.for_each([&ret](const Shard& shard) {
+            if(shard.bins.size() > ret.size())
+                ret.resize(shard.bins.size(), T{});
+            for(size_t key{0}; key < shard.bins.size(); ++key)
+                ret[key] += shard.bins[key];
+        });
+        return ret;
+    }
+
+    inline void clear() {
+        _shards.clear();
+    }
+private:
+    struct Shard {
+        std::vector<T> bins;
+        inline bool used() const {
+            return not bins.empty();
+        }
+    };
+    Sharded<Shard> _shards;
+};
+
+/// \brief Best value according to \a Compare (the smallest one by default),
+/// optionally with some data attached to it (e.g. the graph it comes from).
+///
+/// Ties are broken arbitrarily.
+template <typename T, typename Data=std::monostate, typename Compare=std::less<T>>
+class Extremum {
+public:
+    typedef std::pair<T, Data> value_type;
+
+    inline void update(const T& x, const Data& data=Data()) {
+        auto& best{_shards.local().best};
+        if(not best or Compare()(x, best->first))
+            best.emplace(x, data);
+    }
+
+    /// \brief Whether update() would keep \a x (so that its data can be
+    /// computed only when needed). Only meaningful in the calling thread.
+    inline bool improves(const T& x) {
+        const auto& best{_shards.local().best};
+        return not best or Compare()(x, best->first);
+    }
+
+    /// \return The best value and its data, if any value has been given.
+    inline std::optional<value_type> get() const {
+        std::optional<value_type> ret;
+        _shards.for_each([&ret](const Shard& shard) {
+            if(not ret or Compare()(shard.best->first, ret->first))
+                ret = shard.best;
+        });
+        return ret;
+    }
+
+    inline void clear() {
+        _shards.clear();
+    }
+private:
+    struct Shard {
+        std::optional<value_type> best;
+        inline bool used() const {
+            return best.has_value();
+        }
+    };
+    Sharded<Shard> _shards;
+};
+
+/// \brief Smallest value. See Extremum.
+template <typename T, typename Data=std::monostate>
+using Minimum = Extremum<T, Data, std::less<T>>;
+
+/// \brief Largest value. See Extremum.
+template <typename T, typename Data=std::monostate>
+using Maximum = Extremum<T, Data, std::greater<T>>;
+
+/// \brief Values indexed by arbitrary keys, merged with \a Merge
+/// (summed by default) when several threads have a same key.
+template <typename Key, typename Value, typename Merge=std::plus<Value>,
+          typename MapType=std::map<Key, Value>>
+class KeyedMap {
+public:
+    /// \brief Value of \a key in the shard of the calling thread
+    /// (default-constructed if the thread did not see \a key yet).
+    inline Value& operator[](const Key& key) {
+        return _shards.local().map[key];
+    }
+
+    inline MapType get() const {
+        MapType ret;
+        _shards.for_each([&ret](const Shard& shard) {
+            for(const auto& [key, value] : shard.map) {
+                if(auto it{ret.find(key)}; it == ret.end())
+                    ret.emplace(key, value);
+                else
+                    it->second = Merge()(it->second, value);
+            }
+        });
+        return ret;
+    }
+
+    inline void clear() {
+        _shards.clear();
+    }
+private:
+    struct Shard {
+        MapType map;
+        inline bool used() const {
+            return not map.empty();
+        }
+    };
+    Sharded<Shard> _shards;
+};
+
+}  // namespace reducers
+}  // namespace nautypp
+
+#endif
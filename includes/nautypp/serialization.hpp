@@ -0,0 +1,258 @@
+#ifndef NAUTYPP_SERIALIZATION_HPP
+#define NAUTYPP_SERIALIZATION_HPP
+
+/// \file serialization.hpp
+/// \brief Binary (de)serialization of callback results, used by shard files.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace nautypp {
+/// \namespace nautypp::serialization
+/// \brief Portable binary encoding of values.
+///
+/// Integers are written in little-endian order and container sizes as 64-bit
+/// integers, so that files can be produced and read on different hosts.
+/// Support for user-defined types is added by specialising Serializer.
+namespace serialization {
+
+/// \brief Encoder/decoder of values of type \a T.
+///
+/// A specialisation must provide
+/// - `static void write(std::ostream&, const T&)`
+/// - `static T read(std::istream&)`
+template <typename T>
+struct Serializer;
+
+template <typename T>
+concept Serializable = requires(std::ostream& os, std::istream& is, const T& x) {
+    { Serializer<T>::write(os, x) };
+    { Serializer<T>::read(is) } -> std::same_as<T>;
+};
+
+template <Serializable T>
+inline void write(std::ostream& os, const T& x) {
+    Serializer<T>::write(os, x);
+}
+
+template <Serializable T>
+inline T read(std::istream& is) {
+    return Serializer<T>::read(is);
+}
+
+/// \brief Thrown when a stream ends before a value is fully read.
+class TruncatedStream : public std::runtime_error {
+public:
+    TruncatedStream(): std::runtime_error("Unexpected end of serialized data") {
+    }
+};
+
+namespace detail {
+template <std::unsigned_integral U>
+inline void write_unsigned(std::ostream& os, U x) {
+    std::array<char, sizeof(U)> bytes;
+    for(auto& byte : bytes) {
+        byte = static_cast<char>(x & 0xFF);
+        if constexpr(sizeof(U) > 1)
+            x >>= 8;
+    }
+    os.write(bytes.data(), bytes.size());
+}
+
+template <std::unsigned_integral U>
+inline U read_unsigned(std::istream& is) {
+    std::array<char, sizeof(U)> bytes;
+    if(not is.read(bytes.data(), bytes.size()))
+        throw TruncatedStream();
+    U ret{0};
+    for(size_t i{sizeof(U)}; i > 0; --i) {
+        if constexpr(sizeof(U) > 1)
+            ret <<= 8;
+        ret |= static_cast<U>(static_cast<unsigned char>(bytes[i-1]));
+    }
+    return ret;
+}
+
+inline void write_size(std::ostream& os, size_t size) {
+    write_unsigned<std::uint64_t>(os, size);
+}
+
+inline size_t read_size(std::istream& is) {
+    return static_cast<size_t>(read_unsigned<std::uint64_t>(is));
+}
+
+/// Largest number of elements reserved up front for a container being read.
+static constexpr size_t MAX_RESERVE{1 << 16};
+
+/* a size read from a corrupted stream must end in TruncatedStream, hence the
+ * containers only grow beyond MAX_RESERVE as their elements are read */
+inline size_t reserve_for(size_t size) {
+    return std::min(size, MAX_RESERVE);
+}
+
+/// Containers filled element by element through `insert`.
+template <typename C>
+concept InsertableContainer = requires(C c, typename C::value_type x) {
+    { c.size() } -> std::convertible_to<size_t>;
+    { c.insert(std::move(x)) };
+};
+}
+
+template <typename T>
+requires std::is_integral_v<T> or std::is_enum_v<T>
+struct Serializer<T> {
+    typedef std::make_unsigned_t<typename std::conditional_t<
+        std::is_enum_v<T>, std::underlying_type<T>, std::type_identity<T>
+    >::type> Unsigned;
+
+    static inline void write(std::ostream& os, const T& x) {
+        detail::write_unsigned<Unsigned>(os, static_cast<Unsigned>(x));
+    }
+
+    static inline T read(std::istream& is) {
+        return static_cast<T>(detail::read_unsigned<Unsigned>(is));
+    }
+};
+
+template <>
+struct Serializer<bool> {
+    static inline void write(std::ostream& os, const bool& x) {
+        detail::write_unsigned<std::uint8_t>(os, x ? 1 : 0);
+    }
+
+    static inline bool read(std::istream& is) {
+        return detail::read_unsigned<std::uint8_t>(is) != 0;
+    }
+};
+
+template <std::floating_point T>
+requires (sizeof(T) == 4 or sizeof(T) == 8)
+struct Serializer<T> {
+    typedef std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t> Bits;
+
+    static inline void write(std::ostream& os, const T& x) {
+        detail::write_unsigned<Bits>(os, std::bit_cast<Bits>(x));
+    }
+
+    static inline T read(std::istream& is) {
+        return std::bit_cast<T>(detail::read_unsigned<Bits>(is));
+    }
+};
+
+template <Serializable T1, Serializable T2>
+struct Serializer<std::pair<T1, T2>> {
+    static inline void write(std::ostream& os, const std::pair<T1, T2>& x) {
+        serialization::write(os, x.first);
+        serialization::write(os, x.second);
+    }
+
+    static inline std::pair<T1, T2> read(std::istream& is) {
+        auto first{serialization::read<T1>(is)};
+        return {std::move(first), serialization::read<T2>(is)};
+    }
+};
+
+template <Serializable T, size_t N>
+struct Serializer<std::array<T, N>> {
+    static inline void write(std::ostream& os, const std::array<T, N>& x) {
+        for(const auto& element : x)
+            serialization::write(os, element);
+    }
+
+    static inline std::array<T, N> read(std::istream& is) {
+        return [&is]<size_t... I>(std::index_sequence<I...>) {
+            // braced initialisation guarantees left-to-right evaluation
+            return std::array<T, N>{((void)I, serialization::read<T>(is))...};
+        }(std::make_index_sequence<N>{});
+    }
+};
+
+template <Serializable T, typename Allocator>
+struct Serializer<std::vector<T, Allocator>> {
+    static inline void write(std::ostream& os, const std::vector<T, Allocator>& x) {
+        detail::write_size(os, x.size());
+        for(const auto& element : x)
+            serialization::write(os, element);
+    }
+
+    static inline std::vector<T, Allocator> read(std::istream& is) {
+        std::vector<T, Allocator> ret;
+        auto size{detail::read_size(is)};
+        ret.reserve(detail::reserve_for(size));
+        for(size_t i{0}; i < size; ++i)
+            ret.push_back(serialization::read<T>(is));
+        return ret;
+    }
+};
+
+template <typename Char, typename Traits, typename Allocator>
+struct Serializer<std::basic_string<Char, Traits, Allocator>> {
+    typedef std::basic_string<Char, Traits, Allocator> String;
+
+    static inline void write(std::ostream& os, const String& x) {
+        detail::write_size(os, x.size());
+        for(auto c : x)
+            serialization::write(os, c);
+    }
+
+    static inline String read(std::istream& is) {
+        String ret;
+        auto size{detail::read_size(is)};
+        ret.reserve(detail::reserve_for(size));
+        for(size_t i{0}; i < size; ++i)
+            ret.push_back(serialization::read<Char>(is));
+        return ret;
+    }
+};
+
+/// Associative containers (`std::map`, `std::set`, their unordered and multi versions).
+template <detail::InsertableContainer C>
+requires requires { typename C::key_type; }
+struct Serializer<C> {
+    static inline void write(std::ostream& os, const C& x) {
+        detail::write_size(os, x.size());
+        for(const auto& element : x) {
+            if constexpr(is_map) {
+                serialization::write(os, element.first);
+                serialization::write(os, element.second);
+            } else {
+                serialization::write(os, element);
+            }
+        }
+    }
+
+    static inline C read(std::istream& is) {
+        C ret;
+        auto size{detail::read_size(is)};
+        for(size_t i{0}; i < size; ++i) {
+            if constexpr(is_map) {
+                auto key{serialization::read<typename C::key_type>(is)};
+                ret.insert({std::move(key), serialization::read<typename C::mapped_type>(is)});
+            } else {
+                ret.insert(serialization::read<typename C::value_type>(is));
+            }
+        }
+        return ret;
+    }
+private:
+    static constexpr bool is_map{requires { typename C::mapped_type; }};
+};
+
+}  // namespace serialization
+}  // namespace nautypp
+
+#endif
@@ -0,0 +1,306 @@
+#ifndef NAUTYPP_SMALL_GRAPH_HPP
+#define NAUTYPP_SMALL_GRAPH_HPP
+
+/// \file small_graph.hpp
+/// \brief Graphs whose rows fit in a single setword, with inline storage.
+
+#include <array>
+#include <bit>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <nautypp/aliases.hpp>
+#include <nautypp/graph.hpp>
+#include <nautypp/view.hpp>
+
+namespace nautypp {
+
+/// \brief Graph on at most \a N vertices (with \a N up to WORDSIZE), stored
+/// inline as one setword per vertex.
+///
+/// Since every row is a single word, the operations compile to a few bit
+/// operations per vertex: degrees are popcounts, neighbours are found with
+/// `std::countl_zero`, and the complement and the connected components
+/// are computed on whole rows at once. Nothing is allocated, and every
+/// method is `constexpr`.
+///
+/// Rows use the bit order of nauty (vertex `v` is the bit `WORDSIZE-1-v`),
+/// so that a SmallGraph can be built from the rows given by geng (e.g. from
+/// the GraphView given to a callback) by copying \a N words at most.
+///
+/// **Example**:
+/// \include small_graph.cpp
+template <size_t N>
+    requires (N > 0 and N <= WORDSIZE)
+class SmallGraph {
+public:
+    /// \brief Iterator over the vertices of a set (in increasing order).
+    class VertexIterator {
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef Vertex value_type;
+
+        constexpr VertexIterator() = default;
+
+        constexpr Vertex operator*() const {
+            return static_cast<Vertex>(std::countl_zero(_bits));
+        }
+
+        constexpr VertexIterator& operator++() {
+            _bits &= ~bit(**this);
+            return *this;
+        }
+
+        constexpr VertexIterator operator++(int) {
+            auto ret{*this};
+            ++*this;
+            return ret;
+        }
+
+        constexpr bool operator==(const VertexIterator& other) const {
+            return _bits == other._bits;
+        }
+    private:
+        setword _bits{0};
+
+        constexpr VertexIterator(setword bits): _bits{bits} {
+        }
+
+        friend class SmallGraph;
+    };
+
+    /// \brief Range of the vertices of a set, e.g. the neighbours of a vertex.
+    class Vertices {
+    public:
+        constexpr VertexIterator begin() const {
+            return VertexIterator(_bits);
+        }
+
+        constexpr VertexIterator end() const {
+            return VertexIterator(0);
+        }
+
+        constexpr size_t size() const {
+            return static_cast<size_t>(std::popcount(_bits));
+        }
+
+        inline operator std::vector<Vertex>() const {
+            return std::vector<Vertex>(begin(), end());
+        }
+    private:
+        setword _bits;
+
+        constexpr Vertices(setword bits): _bits{bits} {
+        }
+
+        friend class SmallGraph;
+    };
+
+    /// \brief Empty graph on \a V vertices.
+    constexpr explicit SmallGraph(size_t V=N): _rows{}, _n{V} {
+        if(V > N)
+            throw std::runtime_error("Too many vertices for a SmallGraph");
+    }
+
+    /// \brief Copy of the graph with rows \a rows (in the nauty format) on \a V vertices.
+    constexpr SmallGraph(const graph* rows, size_t V): SmallGraph(V) {
+        for(Vertex v{0}; v < V; ++v)
+            _rows[v] = rows[v];
+    }
+
+    /// \brief Copy of the graph seen by \a G.
+    constexpr explicit SmallGraph(const GraphView& G): SmallGraph(G.rows(), G.V()) {
+    }
+
+    /// \brief Copy of \a G.
+    explicit SmallGraph(const Graph& G): SmallGraph(G.view()) {
+    }
+
+    /// \brief Read-only view over the rows of the graph.
+    constexpr GraphView view() const {
+        return GraphView(_rows.data(), _n);
+    }
+
+    /// \brief Copy the graph into a Graph.
+    inline Graph to_graph() const {
+        return Graph(_rows.data(), _n);
+    }
+
+    /// \brief Row of a vertex: the set of its neighbours.
+    constexpr setword row(Vertex v) const {
+        return _rows[v];
+    }
+
+    /// \brief Number of vertices of the graph.
+    constexpr size_t V() const {
+        return _n;
+    }
+
+    /// \brief Number of edges of the graph.
+    constexpr size_t E() const {
+        size_t ret{0};
+        for(Vertex v{0}; v < _n; ++v)
+            ret += degree(v);
+        return ret / 2;
+    }
+
+    /// \brief Get the degree of a vertex.
+    constexpr size_t degree(Vertex v) const {
+        return static_cast<size_t>(std::popcount(_rows[v]));
+    }
+
+    /// \brief Get the degree of every vertex.
+    inline std::vector<size_t> degree() const {
+        std::vector<size_t> ret(_n);
+        for(Vertex v{0}; v < _n; ++v)
+            ret[v] = degree(v);
+        return ret;
+    }
+
+    /// \brief Get both the minimum and the maximum degree of the graph.
+    ///
+    /// \return A pair `{delta, Delta}` (`{0, 0}` for the empty graph).
+    constexpr std::pair<size_t, size_t> delta_Delta() const {
+        if(_n == 0)
+            return {0, 0};
+        size_t min{_n}, max{0};
+        for(Vertex v{0}; v < _n; ++v) {
+            const auto d{degree(v)};
+            min = d < min ? d : min;
+            max = d > max ? d : max;
+        }
+        return {min, max};
+    }
+
+    /// \brief Get the minimum degree \f$\delta(G)\f$ of the graph.
+    constexpr size_t delta() const {
+        return delta_Delta().first;
+    }
+
+    /// \brief Get the maximum degree \f$\Delta(G)\f$ of the graph.
+    constexpr size_t Delta() const {
+        return delta_Delta().second;
+    }
+
+    /// \brief Determine if two vertices are linked by an edge.
+    constexpr bool are_linked(Vertex v, Vertex w) const {
+        return (_rows[v] & bit(w)) != 0;
+    }
+
+    /// Alias of are_linked()
+    constexpr bool has_edge(Vertex v, Vertex w) const {
+        return are_linked(v, w);
+    }
+
+    /// \brief Add an edge between two vertices.
+    constexpr void link(Vertex v, Vertex w) {
+        _rows[v] |= bit(w);
+        _rows[w] |= bit(v);
+    }
+
+    /// Alias of link()
+    constexpr void add_edge(Vertex v, Vertex w) {
+        link(v, w);
+    }
+
+    /// \brief Remove the edge between two vertices (if any).
+    constexpr void unlink(Vertex v, Vertex w) {
+        _rows[v] &= ~bit(w);
+        _rows[w] &= ~bit(v);
+    }
+
+    /// \brief Get the neighbours of a vertex.
+    constexpr Vertices neighbours_of(Vertex v) const {
+        return Vertices(_rows[v]);
+    }
+
+    /// Alias of neighbours_of()
+    constexpr Vertices neighbors_of(Vertex v) const {
+        return neighbours_of(v);
+    }
+
+    /// \brief Construct the complement of the graph.
+    constexpr SmallGraph complement() const {
+        SmallGraph ret(_n);
+        const auto all{vertices_mask()};
+        for(Vertex v{0}; v < _n; ++v)
+            ret._rows[v] = ~_rows[v] & all & ~bit(v);
+        return ret;
+    }
+
+    /// \brief Get the vertices of the connected component of a vertex.
+    constexpr Vertices component_of(Vertex v) const {
+        return Vertices(component_mask(v));
+    }
+
+    /// \brief Count the connected components of the graph.
+    constexpr size_t nb_connected_components() const {
+        size_t ret{0};
+        for(setword remaining{vertices_mask()}; remaining != 0; ++ret)
+            remaining &= ~component_mask(static_cast<Vertex>(std::countl_zero(remaining)));
+        return ret;
+    }
+
+    /// \brief Determine whether the graph is connected (the empty graph is not).
+    constexpr bool is_connected() const {
+        return _n > 0 and component_mask(0) == vertices_mask();
+    }
+
+    constexpr bool operator==(const SmallGraph& other) const = default;
+
+    /// \brief Path on \a V vertices.
+    static constexpr SmallGraph make_path(size_t V) {
+        SmallGraph ret(V);
+        for(Vertex v{1}; v < V; ++v)
+            ret.link(v-1, v);
+        return ret;
+    }
+
+    /// \brief Cycle on \a V vertices.
+    static constexpr SmallGraph make_cycle(size_t V) {
+        auto ret{make_path(V)};
+        ret.link(0, V-1);
+        return ret;
+    }
+
+    /// \brief Complete graph on \a V vertices.
+    static constexpr SmallGraph make_complete(size_t V) {
+        return SmallGraph(V).complement();
+    }
+private:
+    std::array<setword, N> _rows;
+    size_t                 _n;
+
+    /* the set {v} in the bit order of nauty */
+    static constexpr setword bit(Vertex v) {
+        return setword{1} << (WORDSIZE-1-v);
+    }
+
+    /* the set of all the vertices */
+    constexpr setword vertices_mask() const {
+        return _n == 0 ? 0 : ~setword{0} << (WORDSIZE-_n);
+    }
+
+    /* vertices reachable from v, found one row at a time */
+    constexpr setword component_mask(Vertex v) const {
+        setword component{bit(v)};
+        for(setword frontier{component}; frontier != 0;) {
+            const auto w{static_cast<Vertex>(std::countl_zero(frontier))};
+            const setword discovered{_rows[w] & ~component};
+            component |= discovered;
+            frontier = (frontier & ~bit(w)) | discovered;
+        }
+        return component;
+    }
+};
+
+#if WORDSIZE == 64
+/// \brief Graph on at most 64 vertices. See SmallGraph.
+typedef SmallGraph<64> Graph64;
+#endif
+
+}  // namespace nautypp
+
+#endif
@@ -0,0 +1,325 @@
+#ifndef NAUTYPP_STATISTICS_HPP
+#define NAUTYPP_STATISTICS_HPP
+
+/// \file statistics.hpp
+/// \brief Instrumentation of the producer/worker pipeline of a run.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include <nautypp/aliases.hpp>
+
+namespace nautypp {
+
+/// \brief Counters of the pipeline of a run (see NautyParameters::statistics).
+///
+/// Every producer (instance of geng/gentreeg) and every worker updates its
+/// own probe, on its own cache lines and without atomic read-modify-write,
+/// and snapshot() can be called from any other thread while the run goes on.
+/// Workers spending their time waiting mean that the run is producer-bound
+/// (more producers may help), and producers spending theirs stalled on full
+/// buffers mean that it is consumer-bound (more workers may help).
+///
+/// If a summary stream is given, the statistics are written to it at the
+/// end of the run.
+///
+/// An object must only be used by one run at a time: starting a run resets it.
+///
+/// **Example**:
+/// \include multithreaded/statistics.cpp
+class PipelineStatistics {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// Number of buckets of the histograms: the value `x` is counted in the
+    /// bucket `std::bit_width(x)` (the last bucket being unbounded).
+    static constexpr size_t NB_BUCKETS{48};
+    typedef std::array<std::uint64_t, NB_BUCKETS> Histogram;
+
+    /// \brief Statistics of a producer.
+    struct Producer {
+        std::uint64_t produced{0};  ///< graphs pushed into the buffers
+        std::uint64_t stalls{0};    ///< graphs for which every buffer was full
+        double        stalled{0};   ///< seconds spent waiting for room in the buffers
+        double        elapsed{0};   ///< seconds since the start of the run (or until the producer was over)
+        bool          over{false};  ///< whether the producer is done
+        Histogram     occupancy{};  ///< size of the buffer a graph was pushed in (graph included)
+
+        /// \brief Graphs produced per second.
+        inline double throughput() const {
+            return elapsed > 0 ? static_cast<double>(produced) / elapsed : 0.;
+        }
+    };
+
+    /// \brief Statistics of a worker.
+    struct Worker {
+        std::uint64_t consumed{0};  ///< graphs processed (stolen ones included)
+        std::uint64_t stolen{0};    ///< graphs stolen from other workers
+        std::uint64_t calls{0};     ///< calls of the callback (one per batch for batch callbacks)
+        std::uint64_t waits{0};     ///< times the worker had nothing to do
+        double        waiting{0};   ///< seconds spent waiting for graphs
+        double        busy{0};      ///< seconds spent in the callback
+        Histogram     call_time{};  ///< duration (in nanoseconds) of the calls of the callback
+
+        /// \brief Graphs processed per second spent in the callback.
+        inline double throughput() const {
+            return busy > 0 ? static_cast<double>(consumed) / busy : 0.;
+        }
+    };
+
+    /// \brief Statistics of the whole run at some point in time.
+    struct Snapshot {
+        double                elapsed{0};   ///< seconds since the start of the run (or until its end)
+        bool                  over{false};  ///< whether the run is over
+        std::vector<Producer> producers;
+        std::vector<Worker>   workers;
+
+        /// \brief Graphs produced by every producer.
+        inline std::uint64_t produced() const {
+            std::uint64_t ret{0};
+            for(const auto& producer : producers)
+                ret += producer.produced;
+            return ret;
+        }
+
+        /// \brief Graphs processed by every worker.
+        inline std::uint64_t consumed() const {
+            std::uint64_t ret{0};
+            for(const auto& worker : workers)
+                ret += worker.consumed;
+            return ret;
+        }
+
+        /// \brief Write a human-readable summary of the statistics.
+        inline void print(std::ostream& os) const {
+            os << "Run " << (over ? "over" : "running") << " after "
+               << elapsed << "s: " << produced() << " graphs produced, "
+               << consumed() << " processed\n";
+            for(size_t i{0}; i < producers.size(); ++i) {
+                const auto& producer{producers[i]};
+                os << "  producer " << i+1 << ": " << producer.produced << " graphs ("
+                   << producer.throughput() << "/s), stalled " << producer.stalls
+                   << " times (" << producer.stalled << "s), buffer occupancy median <= "
+                   << quantile(producer.occupancy, .5) << ", max <= "
+                   << quantile(producer.occupancy, 1.) << '\n';
+            }
+            for(size_t i{0}; i < workers.size(); ++i) {
+                const auto& worker{workers[i]};
+                os << "  worker " << i+1 << ": " << worker.consumed << " graphs ("
+                   << worker.stolen << " stolen, " << worker.throughput()
+                   << "/s of callback), waited " << worker.waits << " times ("
+                   << worker.waiting << "s), call time median <= "
+                   << quantile(worker.call_time, .5) << "ns, p99 <= "
+                   << quantile(worker.call_time, .99) << "ns\n";
+            }
+        }
+    };
+
+    /// \brief Probe of a producer (only updated by its producer thread).
+    class alignas(CACHE_LINE_SIZE) ProducerProbe {
+    public:
+        inline void record_push(size_t occupancy) {
+            bump(_produced);
+            bump(_occupancy[bucket(occupancy)]);
+        }
+
+        inline void record_stall(clock::duration duration) {
+            bump(_stalls);
+            bump(_stalled, nanoseconds(duration));
+        }
+
+        inline void finish() {
+            _end.store(clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        friend class PipelineStatistics;
+    private:
+        std::atomic_uint64_t _produced{0};
+        std::atomic_uint64_t _stalls{0};
+        std::atomic_uint64_t _stalled{0};
+        std::atomic<clock::rep> _end{0};
+        std::array<std::atomic_uint64_t, NB_BUCKETS> _occupancy{};
+    };
+
+    /// \brief Probe of a worker (only updated by its worker thread).
+    class alignas(CACHE_LINE_SIZE) WorkerProbe {
+    public:
+        inline void record_call(size_t nb_graphs, clock::duration duration) {
+            const auto ns{nanoseconds(duration)};
+            bump(_consumed, nb_graphs);
+            bump(_calls);
+            bump(_busy, ns);
+            bump(_call_time[bucket(ns)]);
+        }
+
+        inline void record_steal(size_t nb_graphs) {
+            bump(_stolen, nb_graphs);
+        }
+
+        inline void record_wait(clock::duration duration) {
+            bump(_waits);
+            bump(_waiting, nanoseconds(duration));
+        }
+
+        friend class PipelineStatistics;
+    private:
+        std::atomic_uint64_t _consumed{0};
+        std::atomic_uint64_t _stolen{0};
+        std::atomic_uint64_t _calls{0};
+        std::atomic_uint64_t _waits{0};
+        std::atomic_uint64_t _waiting{0};
+        std::atomic_uint64_t _busy{0};
+        std::array<std::atomic_uint64_t, NB_BUCKETS> _call_time{};
+    };
+
+    /// \param summary Stream the statistics are written to at the end of every run (if any).
+    PipelineStatistics(std::ostream* summary=nullptr): _summary{summary} {
+    }
+
+    PipelineStatistics(const PipelineStatistics&) = delete;
+    PipelineStatistics& operator=(const PipelineStatistics&) = delete;
+
+    /// \brief Reset the statistics for a run. Called when the run starts.
+    inline void start(size_t nb_producers, size_t nb_workers) {
+        std::lock_guard lock(_mutex);
+        _producers.reset(new ProducerProbe[nb_producers]);
+        _workers.reset(new WorkerProbe[nb_workers]);
+        _nb_producers = nb_producers;
+        _nb_workers = nb_workers;
+        _start = clock::now();
+        _over = false;
+    }
+
+    /// \brief Mark the run as over and write the summary. Called when the run ends.
+    inline void finish() {
+        std::lock_guard lock(_mutex);
+        _end = clock::now();
+        _over = true;
+        if(_summary != nullptr)
+            take_snapshot().print(*_summary);
+    }
+
+    inline ProducerProbe& producer(size_t idx) {
+        return _producers[idx];
+    }
+
+    inline WorkerProbe& worker(size_t idx) {
+        return _workers[idx];
+    }
+
+    /// \brief Current statistics (can be called while the run goes on).
+    inline Snapshot snapshot() const {
+        std::lock_guard lock(_mutex);
+        return take_snapshot();
+    }
+
+    /// \brief Upper bound of the \a q-quantile (with \a q in [0, 1]) of a histogram.
+    static inline std::uint64_t quantile(const Histogram& histogram, double q) {
+        std::uint64_t total{0};
+        for(auto count : histogram)
+            total += count;
+        if(total == 0)
+            return 0;
+        const auto rank{std::max<std::uint64_t>(1, static_cast<std::uint64_t>(q * total + .5))};
+        std::uint64_t seen{0};
+        for(size_t k{0}; k < NB_BUCKETS; ++k) {
+            seen += histogram[k];
+            if(seen >= rank)
+                return k == 0 ? 0 : (std::uint64_t{1} << k) - 1;
+        }
+        return std::numeric_limits<std::uint64_t>::max();
+    }
+private:
+    std::ostream*                    _summary;
+    mutable std::mutex               _mutex;
+    std::unique_ptr<ProducerProbe[]> _producers;
+    std::unique_ptr<WorkerProbe[]>   _workers;
+    size_t                           _nb_producers{0};
+    size_t                           _nb_workers{0};
+    clock::time_point                _start;
+    clock::time_point                _end;
+    bool                             _over{false};
+
+    /* increment a counter only written by the calling thread */
+    static inline void bump(std::atomic_uint64_t& counter, std::uint64_t x=1) {
+        counter.store(counter.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+    }
+
+    static inline size_t bucket(std::uint64_t x) {
+        return std::min<size_t>(std::bit_width(x), NB_BUCKETS-1);
+    }
+
+    static inline std::uint64_t nanoseconds(clock::duration duration) {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()
+        );
+    }
+
+    static inline double seconds(std::uint64_t ns) {
+        return static_cast<double>(ns) * 1e-9;
+    }
+
+    template <size_t N>
+    static inline Histogram load(const std::array<std::atomic_uint64_t, N>& counters) {
+        Histogram ret;
+        for(size_t k{0}; k < N; ++k)
+            ret[k] = counters[k].load(std::memory_order_relaxed);
+        return ret;
+    }
+
+    inline Snapshot take_snapshot() const {
+        Snapshot ret;
+        const auto now{_over ? _end : clock::now()};
+        ret.elapsed = std::chrono::duration<double>(now - _start).count();
+        ret.over = _over;
+        for(size_t i{0}; i < _nb_producers; ++i) {
+            const auto& probe{_producers[i]};
+            Producer producer;
+            producer.produced = probe._produced.load(std::memory_order_relaxed);
+            producer.stalls = probe._stalls.load(std::memory_order_relaxed);
+            producer.stalled = seconds(probe._stalled.load(std::memory_order_relaxed));
+            const auto end{probe._end.load(std::memory_order_relaxed)};
+            producer.over = end != 0;
+            producer.elapsed = producer.over
+                ? std::chrono::duration<double>(
+                    clock::time_point(clock::duration(end)) - _start
+                  ).count()
+                : ret.elapsed;
+            producer.occupancy = load(probe._occupancy);
+            ret.producers.push_back(producer);
+        }
+        for(size_t i{0}; i < _nb_workers; ++i) {
+            const auto& probe{_workers[i]};
+            Worker worker;
+            worker.consumed = probe._consumed.load(std::memory_order_relaxed);
+            worker.stolen = probe._stolen.load(std::memory_order_relaxed);
+            worker.calls = probe._calls.load(std::memory_order_relaxed);
+            worker.waits = probe._waits.load(std::memory_order_relaxed);
+            worker.waiting = seconds(probe._waiting.load(std::memory_order_relaxed));
+            worker.busy = seconds(probe._busy.load(std::memory_order_relaxed));
+            worker.call_time = load(probe._call_time);
+            ret.workers.push_back(worker);
+        }
+        return ret;
+    }
+};
+
+/// \brief Write a human-readable summary of the statistics of a run.
+static inline std::ostream& operator<<(std::ostream& os,
+        const PipelineStatistics::Snapshot& snapshot) {
+    snapshot.print(os);
+    return os;
+}
+
+}  // namespace nautypp
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef NAUTYPP_TRACE_HPP
+#define NAUTYPP_TRACE_HPP
+
+/// \file trace.hpp
+/// \brief Timelines of the producer and worker threads of a run.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#include <nautypp/aliases.hpp>
+
+namespace nautypp {
+
+/// \brief Timeline of a run, exported in the Chrome trace format
+/// (readable by `chrome://tracing` and Perfetto).
+///
+/// Every producer and every worker records spans in a ring buffer of its
+/// own (without any synchronisation), keeping its most recent events:
+/// - producers record the bursts in which they generate graphs and the
+///   stalls in which every buffer they feed is full;
+/// - workers record the time they wait for graphs, the graphs they steal,
+///   and one call of the callback every `sample_period` graphs.
+///
+/// Threads are named as in the process (e.g. `nauty-geng-1`, `Worker 3`).
+/// The trace is written to the given path at the end of every run, or can
+/// be written with write() once the run is over.
+///
+/// An object must only be used by one run at a time: starting a run resets it.
+///
+/// **Example**:
+/// \include multithreaded/trace.cpp
+class PipelineTrace {
+public:
+    typedef std::chrono::steady_clock clock;
+
+    /// Kinds of spans.
+    enum class Event : std::uint8_t {
+        PRODUCE,   ///< producer generating graphs
+        STALL,     ///< producer waiting for room in its buffers
+        WAIT,      ///< worker waiting for graphs
+        STEAL,     ///< worker stealing graphs (instant)
+        CALLBACK   ///< one (sampled) call of the callback
+    };
+
+    /// \brief Events of a thread (only written by that thread).
+    class alignas(CACHE_LINE_SIZE) Track {
+    public:
+        /// \brief Record a span (an instant event if \a begin == \a end).
+        inline void record(Event event, clock::time_point begin, clock::time_point end,
+                std::uint32_t nb_graphs=0) {
+            _spans[_next++ & _mask] = Span{begin, end, nb_graphs, event};
+        }
+
+        /// \brief Determine whether the call processing the next \a nb_graphs
+        /// graphs must be recorded (once every `sample_period` graphs).
+        inline bool sample(size_t nb_graphs) {
+            _seen += nb_graphs;
+            if(_seen < _next_sample)
+                return false;
+            _next_sample = _seen + _period;
+            return true;
+        }
+
+        inline void set_name(const std::string& name) {
+            _name = name;
+        }
+
+        friend class PipelineTrace;
+    private:
+        struct Span {
+            clock::time_point begin;
+            clock::time_point end;
+            std::uint32_t     nb_graphs;
+            Event             event;
+        };
+
+        std::string             _name;
+        std::unique_ptr<Span[]> _spans;
+        size_t                  _mask{0};
+        size_t                  _next{0};
+        size_t                  _period{1};
+        size_t                  _seen{0};
+        size_t                  _next_sample{0};
+    };
+
+    /// \param path File the trace is written to at the end of every run (if not empty).
+    /// \param events_per_thread Number of most recent events kept by every thread.
+    /// \param sample_period Number of graphs between two recorded calls of the callback.
+    PipelineTrace(const std::string& path="", size_t events_per_thread=1 << 16,
+            size_t sample_period=64):
+            _path{path},
+            _capacity{std::bit_ceil(std::max<size_t>(events_per_thread, 1))},
+            _period{std::max<size_t>(sample_period, 1)} {
+    }
+
+    PipelineTrace(const PipelineTrace&) = delete;
+    PipelineTrace& operator=(const PipelineTrace&) = delete;
+
+    /// \brief Reset the trace for a run. Called when the run starts.
+    inline void start(size_t nb_producers, size_t nb_workers) {
+        _nb_tracks = nb_producers + nb_workers;
+        _nb_producers = nb_producers;
+        _tracks.reset(new Track[_nb_tracks]);
+        for(size_t i{0}; i < _nb_tracks; ++i) {
+            auto& track{_tracks[i]};
+            track._spans.reset(new Track::Span[_capacity]);
+            track._mask = _capacity-1;
+            track._period = _period;
+            track._name = i < nb_producers
+                ? "producer " + std::to_string(i+1)
+                : "worker " + std::to_string(i-nb_producers+1);
+        }
+        _start = clock::now();
+    }
+
+    /// \brief Write the trace to the path (if any). Called when the run ends.
+    inline void finish() const {
+        if(_path.empty())
+            return;
+        std::ofstream file(_path);
+        write(file);
+        if(not file.flush())
+            throw std::runtime_error("Unable to write trace file " + _path);
+    }
+
+    inline Track& producer(size_t idx) {
+        return _tracks[idx];
+    }
+
+    inline Track& worker(size_t idx) {
+        return _tracks[_nb_producers + idx];
+    }
+
+    /// \brief Write the trace in the Chrome trace (JSON) format.
+    ///
+    /// Must only be called when no run is using the trace.
+    inline void write(std::ostream& os) const {
+        const auto flags{os.flags()};
+        const auto precision{os.precision()};
+        os << std::fixed << std::setprecision(3);
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,"
+           << "\"args\":{\"name\":\"nautypp\"}}";
+        for(size_t tid{0}; tid < _nb_tracks; ++tid) {
+            const auto& track{_tracks[tid]};
+            os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid+1
+               << ",\"args\":{\"name\":\"";
+            write_escaped(os, track._name);
+            os << "\"}}";
+            const auto nb_spans{std::min(track._next, _capacity)};
+            for(auto i{track._next - nb_spans}; i < track._next; ++i)
+                write_span(os, track._spans[i & track._mask], tid+1);
+        }
+        os << "\n]}\n";
+        os.flags(flags);
+        os.precision(precision);
+    }
+private:
+    static constexpr std::array<const char*, 5> NAMES{
+        "produce", "stall", "wait", "steal", "callback"
+    };
+
+    std::string              _path;
+    size_t                   _capacity;
+    size_t                   _period;
+    std::unique_ptr<Track[]> _tracks;
+    size_t                   _nb_tracks{0};
+    size_t                   _nb_producers{0};
+    clock::time_point        _start;
+
+    /* microseconds since the start of the run */
+    inline double timestamp(clock::time_point t) const {
+        return std::chrono::duration<double, std::micro>(t - _start).count();
+    }
+
+    inline void write_span(std::ostream& os, const Track::Span& span, size_t tid) const {
+        const auto event{static_cast<size_t>(span.event)};
+        os << ",\n{\"name\":\"" << NAMES[event] << "\",\"cat\":\""
+           << (span.event <= Event::STALL ? "producer" : "worker") << "\",\"pid\":1,\"tid\":"
+           << tid << ",\"ts\":" << timestamp(span.begin);
+        if(span.begin == span.end)
+            os << ",\"ph\":\"i\",\"s\":\"t\"";
+        else
+            os << ",\"ph\":\"X\",\"dur\":" << timestamp(span.end) - timestamp(span.begin);
+        if(span.nb_graphs > 0)
+            os << ",\"args\":{\"graphs\":" << span.nb_graphs << '}';
+        os << '}';
+    }
+
+    static inline void write_escaped(std::ostream& os, const std::string& s) {
+        for(auto c : s) {
+            if(c == '"' or c == '\\')
+                os << '\\';
+            os << c;
+        }
+    }
+};
+
+}  // namespace nautypp
+
+#endif
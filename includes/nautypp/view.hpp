@@ -0,0 +1,476 @@
+#ifndef NAUTYPP_VIEW_HPP
+#define NAUTYPP_VIEW_HPP
+
+/// \file view.hpp
+/// \brief Read-only graphs over adjacency rows owned by someone else.
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <nauty/nauty.h>
+#include "nauty/planarity.h"
+
+#include <nautypp/aliases.hpp>
+#include <nautypp/cliquer.hpp>
+#include <nautypp/kernels.hpp>
+
+namespace nautypp {
+
+/// \brief Read-only graph over packed adjacency rows (in the nauty format).
+///
+/// A view is a pointer to the rows and the order of the graph: it is
+/// trivially copyable, allocates nothing and caches nothing, and can be
+/// passed around by value. Its properties are computed from the rows on
+/// every call (degrees are popcounts of the rows).
+///
+/// The rows must outlive the view. The view given to a callback (see
+/// GraphViewFunctionType) is only valid during the call: use copy() to keep
+/// the graph.
+///
+/// Most of the read-only methods of Graph are provided.
+class GraphView {
+public:
+    /// \brief Iterator over the neighbours of a vertex. See GraphView::Neighbours.
+    class NeighbourIterator {
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef Vertex value_type;
+
+        NeighbourIterator() = default;
+
+        inline Vertex operator*() const {
+            return static_cast<Vertex>(_w);
+        }
+
+        inline NeighbourIterator& operator++() {
+            _w = nextelement(const_cast<set*>(_row), _m, _w);
+            return *this;
+        }
+
+        inline NeighbourIterator operator++(int) {
+            auto ret{*this};
+            ++*this;
+            return ret;
+        }
+
+        inline bool operator==(const NeighbourIterator& other) const {
+            return _w == other._w;
+        }
+    private:
+        const set* _row{nullptr};
+        int        _m{0};
+        int        _w{-1};
+
+        NeighbourIterator(const set* row, int m, int w): _row{row}, _m{m}, _w{w} {
+        }
+
+        friend class GraphView;
+    };
+
+    /// \brief Range of the neighbours of a vertex, in increasing order.
+    class Neighbours {
+    public:
+        inline NeighbourIterator begin() const {
+            return ++NeighbourIterator(_row, _m, -1);
+        }
+
+        inline NeighbourIterator end() const {
+            return NeighbourIterator(_row, _m, -1);
+        }
+
+        inline operator std::vector<Vertex>() const {
+            return std::vector<Vertex>(begin(), end());
+        }
+    private:
+        const set* _row;
+        int        _m;
+
+        Neighbours(const set* row, int m): _row{row}, _m{m} {
+        }
+
+        friend class GraphView;
+    };
+
+    /// \brief Iterator over the edges `{v, w}` (with `v < w`) of a graph.
+    class EdgeIterator {
+    public:
+        typedef std::ptrdiff_t difference_type;
+        typedef std::pair<Vertex, Vertex> value_type;
+
+        EdgeIterator() = default;
+
+        inline std::pair<Vertex, Vertex> operator*() const {
+            return {_v, static_cast<Vertex>(_w)};
+        }
+
+        inline EdgeIterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        inline EdgeIterator operator++(int) {
+            auto ret{*this};
+            advance();
+            return ret;
+        }
+
+        inline bool operator==(const EdgeIterator& other) const {
+            return _v == other._v and _w == other._w;
+        }
+    private:
+        const GraphView* _graph{nullptr};
+        Vertex           _v{0};
+        int              _w{-1};
+
+        EdgeIterator(const GraphView* graph, Vertex v): _graph{graph}, _v{v} {
+        }
+
+        /* next neighbour w > v, moving on to the next vertices if needed */
+        inline void advance() {
+            const auto m{static_cast<int>(_graph->_m)};
+            while(_v < _graph->V()) {
+                const int w{nextelement(const_cast<set*>(_graph->row(_v)), m, _w)};
+                if(w >= 0) {
+                    _w = w;
+                    return;
+                }
+                ++_v;
+                _w = static_cast<int>(_v);
+            }
+            _w = -1;
+        }
+
+        friend class GraphView;
+    };
+
+    /// \brief Range of the edges of a graph. See GraphView::EdgeIterator.
+    class Edges {
+    public:
+        inline EdgeIterator begin() const {
+            EdgeIterator ret(_graph, 0);
+            ret.advance();
+            return ret;
+        }
+
+        inline EdgeIterator end() const {
+            return EdgeIterator(_graph, _graph->V());
+        }
+
+        inline operator std::vector<std::pair<Vertex, Vertex>>() const {
+            return std::vector<std::pair<Vertex, Vertex>>(begin(), end());
+        }
+    private:
+        const GraphView* _graph;
+
+        Edges(const GraphView* graph): _graph{graph} {
+        }
+
+        friend class GraphView;
+    };
+
+    GraphView() = default;
+
+    /// \param rows The adjacency rows (`SETWORDSNEEDED(V)` setwords per vertex).
+    /// \param V The number of vertices.
+    constexpr GraphView(const graph* rows, size_t V):
+            _rows{rows}, _n{V}, _m{SETWORDSNEEDED(V)} {
+    }
+
+    /// \brief Copy the graph into a Graph owning its rows.
+    inline Graph copy() const;
+
+    /// \brief Packed adjacency rows of the graph.
+    constexpr const graph* rows() const {
+        return _rows;
+    }
+
+    /// \brief Adjacency row of a vertex.
+    inline const set* row(Vertex v) const {
+        return GRAPHROW(_rows, v, _m);
+    }
+
+    /// \brief Number of setwords per row.
+    constexpr size_t m() const {
+        return _m;
+    }
+
+    /// \brief Number of vertices of the graph.
+    constexpr size_t V() const {
+        return _n;
+    }
+
+    /// \brief Number of edges of the graph.
+    inline size_t E() const {
+        return kernels::popcount(_rows, _n*_m) / 2;
+    }
+
+    /// \brief Get the degree of a vertex.
+    inline size_t degree(Vertex v) const {
+        const auto gv{row(v)};
+        size_t ret{0};
+        for(size_t i{0}; i < _m; ++i)
+            ret += std::popcount(gv[i]);
+        return ret;
+    }
+
+    /// \brief Get the degree of every vertex (see Graph::degree()).
+    inline std::vector<size_t> degree() const {
+        std::vector<size_t> ret(V());
+        degree(ret);
+        return ret;
+    }
+
+    /// \brief Write the degree of every vertex into \a degrees (of size at
+    /// least V()), in one pass over the rows. Nothing is allocated.
+    inline void degree(std::span<size_t> degrees) const {
+        kernels::degrees(_rows, _n, _m, degrees.data());
+    }
+
+    /// \brief Get the minimum degree \f$\delta(G)\f$ of the graph.
+    inline size_t delta() const {
+        return delta_Delta().first;
+    }
+
+    /// Alias of delta()
+    inline size_t min_degree() const { return delta(); }
+
+    /// \brief Get the maximum degree \f$\Delta(G)\f$ of the graph.
+    inline size_t Delta() const {
+        return delta_Delta().second;
+    }
+
+    /// Alias of Delta()
+    inline size_t max_degree() const { return Delta(); }
+
+    /// \brief Get both the minimum and the maximum degree of the graph, in
+    /// one pass over the rows.
+    ///
+    /// \return A pair `{delta, Delta}` (`{0, 0}` for the empty graph).
+    inline std::pair<size_t, size_t> delta_Delta() const {
+        if(V() == 0)
+            return {0, 0};
+        size_t min{V()}, max{0};
+        kernels::for_each_degree_chunk(_rows, _n, _m,
+            [&min, &max](size_t, const size_t* degrees, size_t k) {
+                const auto [min_it, max_it] = std::minmax_element(degrees, degrees+k);
+                min = std::min(min, *min_it);
+                max = std::max(max, *max_it);
+            }
+        );
+        return {min, max};
+    }
+
+    /// Get the degree distribution of the graph (see Graph::DegreeDistribution).
+    inline std::vector<std::pair<size_t, size_t>> degree_distribution() const {
+        std::vector<size_t> counts(V());
+        degree_distribution(counts);
+        std::vector<std::pair<size_t, size_t>> ret;
+        for(size_t d{0}; d < V(); ++d)
+            if(counts[d] > 0)
+                ret.emplace_back(d, counts[d]);
+        return ret;
+    }
+
+    /// \brief Write the number of vertices of degree `d` into `counts[d]`
+    /// for every `d < V()` (\a counts must have room for V() values), in one
+    /// pass over the rows. Nothing is allocated.
+    inline void degree_distribution(std::span<size_t> counts) const {
+        std::fill_n(counts.begin(), V(), size_t{0});
+        kernels::for_each_degree_chunk(_rows, _n, _m,
+            [&counts](size_t, const size_t* degrees, size_t k) {
+                for(size_t i{0}; i < k; ++i)
+                    ++counts[degrees[i]];
+            }
+        );
+    }
+
+    /// \brief Determine if two vertices are linked by an edge.
+    inline bool are_linked(Vertex v, Vertex w) const {
+        return ISELEMENT(row(v), w);
+    }
+
+    /// Alias of are_linked()
+    inline bool has_edge(Vertex v, Vertex w) const {
+        return are_linked(v, w);
+    }
+
+    /// \brief Get the neighbours of a vertex.
+    inline Neighbours neighbours_of(Vertex v) const {
+        return Neighbours(row(v), static_cast<int>(_m));
+    }
+
+    /// Alias of neighbours_of()
+    inline Neighbours neighbors_of(Vertex v) const {
+        return neighbours_of(v);
+    }
+
+    /// \brief Check whether some vertex is a leaf.
+    inline bool is_leaf(Vertex v) const {
+        return degree(v) == 1;
+    }
+
+    /// \brief Get an iterable over the edges `{v, w}` of the graph (with `v < w`).
+    inline Edges edges() const {
+        return Edges(this);
+    }
+
+    /// \brief Count the connected components of the graph.
+    inline size_t nb_connected_components() const {
+        return connected_components().second;
+    }
+
+    /// \brief Determine whether the graph is connected (the empty graph is not).
+    inline bool is_connected() const {
+        return V() > 0 and nb_connected_components() == 1;
+    }
+
+    /// \brief Get the connected components of the graph.
+    ///
+    /// \return A pair `{ids, nb}` where `ids[v]` is the identifier (in
+    /// `0..nb-1`) of the component of the vertex `v`.
+    inline std::pair<std::vector<size_t>, size_t> connected_components() const {
+        std::vector<size_t> ids(V(), V());
+        std::vector<Vertex> stack;
+        size_t nb{0};
+        for(Vertex root{0}; root < V(); ++root) {
+            if(ids[root] != V())
+                continue;
+            ids[root] = nb;
+            stack.push_back(root);
+            while(not stack.empty()) {
+                const auto v{stack.back()};
+                stack.pop_back();
+                for(auto w : neighbours_of(v)) {
+                    if(ids[w] == V()) {
+                        ids[w] = nb;
+                        stack.push_back(w);
+                    }
+                }
+            }
+            ++nb;
+        }
+        return {std::move(ids), nb};
+    }
+
+    // Small cliques, counted on the rows (see kernels::count_cliques())
+
+    /// \brief Count the cliques on \a k vertices (see Graph::nb_cliques()).
+    inline size_t nb_cliques(size_t k) const {
+        return kernels::count_cliques(_rows, _n, _m, k);
+    }
+
+    /// \brief Count the triangles of the graph (see Graph::nb_triangles()).
+    inline size_t nb_triangles() const {
+        return nb_cliques(3);
+    }
+
+    /// \brief Count the \f$K_4\f$ subgraphs of the graph (see Graph::nb_K4()).
+    inline size_t nb_K4() const {
+        return nb_cliques(4);
+    }
+
+    /// \brief Determine whether the graph contains \f$K_k\f$ (see Graph::has_clique()).
+    inline bool has_clique(size_t k) const {
+        return kernels::count_cliques(_rows, _n, _m, k, 1) > 0;
+    }
+
+    /// \brief Determine whether the graph contains a triangle (see Graph::has_triangle()).
+    inline bool has_triangle() const {
+        return has_clique(3);
+    }
+
+    // Cliquer: the graph is converted for every call
+
+    /// \brief Find some clique in the graph (see Graph::find_some_clique()).
+    Cliquer::Set find_some_clique(size_t minsize, size_t maxsize, bool maximal) const;
+
+    /// \brief Get the clique number \f$\omega(G)\f$ of the graph.
+    inline size_t max_clique() const {
+        return V() == 0 ? 0 : find_some_clique(0, 0, true).size();
+    }
+
+    /// \brief Apply some callback to every generated clique (see Graph::apply_to_cliques()).
+    size_t apply_to_cliques(size_t minsize, size_t maxsize, bool maximal,
+            std::function<bool(const std::vector<Vertex>&)> callback) const;
+
+    /// \brief Generate all cliques from the graph (see Graph::get_all_cliques()).
+    std::vector<Cliquer::Set> get_all_cliques(size_t minsize, size_t maxsize,
+            bool maximal) const;
+
+    /// \brief Determine whether the graph is planar (see Graph::is_planar()).
+    inline bool is_planar() const {
+        return planar(*this);
+    }
+
+    /// \brief Determine whether a graph is planar.
+    ///
+    /// Shared by Graph and GraphView: builds the representation of
+    /// nauty::planarity from the neighbours of every vertex.
+    template <typename G>
+    static bool planar(const G& graph) {
+        const size_t n{graph.V()};
+        // see nauty::planarg.c::isplanar
+        DYNALLSTAT(t_ver_sparse_rep,  V, V_sz);
+        DYNALLSTAT(t_adjl_sparse_rep, A, A_sz);
+        DYNALLOC1(t_ver_sparse_rep,   V, V_sz, n,               "is_planar");
+        DYNALLOC1(t_adjl_sparse_rep,  A, A_sz, 2*graph.E()+1, "is_planar");
+        t_dlcl **dfs_tree, **back_edges, **mult_edges;
+        t_ver_edge *embed_graph;
+        int edge_pos, v, w, c;
+        // Conversion to nauty::planarity adjl format
+        int k{0};
+        for(Vertex v{0}; v < n; ++v) {
+            if(graph.degree(v) == 0) {
+                V[v].first_edge = NIL;
+            } else {
+                V[v].first_edge = k;
+                for(Vertex w : graph.neighbours_of(v)) {
+                    A[k].end_vertex = w;
+                    A[k].next = k+1;
+                    ++k;
+                    // No need to handle loop
+                }
+                A[k-1].next = NIL;
+            }
+        }
+        // see nauty::planarity.c
+        bool ret{static_cast<bool>(sparseg_adjl_is_planar(
+            V, n, A, &c,
+            &dfs_tree, &back_edges, &mult_edges,
+            &embed_graph, &edge_pos, &v, &w
+        ))};
+        sparseg_dlcl_delete(dfs_tree, n);
+        sparseg_dlcl_delete(back_edges, n);
+        sparseg_dlcl_delete(mult_edges, n);
+        embedg_VES_delete(embed_graph, n);
+        DYNFREE(V, V_sz);
+        DYNFREE(A, A_sz);
+        return ret;
+    }
+private:
+    const graph* _rows{nullptr};
+    size_t       _n{0};
+    size_t       _m{1};
+
+    friend class PropertyCache;
+
+    /* the graph in the format of cliquer (to be freed with graph_free) */
+    inline cliquer_graph_t* to_cliquer() const {
+        auto ret{graph_new(static_cast<int>(V()))};
+        for(auto [v, w] : edges())
+            GRAPH_ADD_EDGE(ret, v, w);
+        return ret;
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<GraphView>);
+
+}  // namespace nautypp
+
+#endif
@@ -0,0 +1,272 @@
+#include <bit>
+#include <vector>
+
+#include "nautypp/kernels.hpp"
+
+#if WORDSIZE == 64 and defined(__x86_64__) and (defined(__GNUC__) or defined(__clang__)) \
+        and not defined(NAUTYPP_NO_SIMD)
+# define NAUTYPP_X86_KERNELS 1
+# include <immintrin.h>
+#else
+# define NAUTYPP_X86_KERNELS 0
+#endif
+
+namespace nautypp::kernels {
+
+/***** Scalar *****/
+
+static void _degrees_scalar(const graph* rows, size_t n, size_t m, size_t* out) {
+    for(size_t v{0}; v < n; ++v, rows += m) {
+        size_t d{0};
+        for(size_t i{0}; i < m; ++i)
+            d += static_cast<size_t>(std::popcount(rows[i]));
+        out[v] = d;
+    }
+}
+
+static size_t _popcount_scalar(const setword* words, size_t nb_words) {
+    size_t ret{0};
+    for(size_t i{0}; i < nb_words; ++i)
+        ret += static_cast<size_t>(std::popcount(words[i]));
+    return ret;
+}
+
+#if NAUTYPP_X86_KERNELS
+
+/***** AVX2 *****/
+
+/* popcount of each 64-bit lane: nibbles are counted with a lookup table,
+ * then the bytes of every lane are summed by psadbw */
+__attribute__((target("avx2")))
+static inline __m256i _popcount_epi64_avx2(__m256i x) {
+    const __m256i lookup{_mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+    )};
+    const __m256i low{_mm256_set1_epi8(0x0f)};
+    const __m256i counts{_mm256_add_epi8(
+        _mm256_shuffle_epi8(lookup, _mm256_and_si256(x, low)),
+        _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(x, 4), low))
+    )};
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+static inline size_t _reduce_add_avx2(__m256i x) {
+    const __m128i sum{_mm_add_epi64(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1))};
+    return static_cast<size_t>(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1));
+}
+
+__attribute__((target("avx2")))
+static size_t _popcount_avx2(const setword* words, size_t nb_words) {
+    __m256i acc{_mm256_setzero_si256()};
+    size_t i{0};
+    for(; i+4 <= nb_words; i += 4)
+        acc = _mm256_add_epi64(acc, _popcount_epi64_avx2(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words+i))
+        ));
+    return _reduce_add_avx2(acc) + _popcount_scalar(words+i, nb_words-i);
+}
+
+__attribute__((target("avx2")))
+static void _degrees_avx2(const graph* rows, size_t n, size_t m, size_t* out) {
+    if(m == 1) {  // one row per lane
+        size_t v{0};
+        for(; v+4 <= n; v += 4)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out+v), _popcount_epi64_avx2(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows+v))
+            ));
+        _degrees_scalar(rows+v, n-v, 1, out+v);
+    } else {
+        for(size_t v{0}; v < n; ++v, rows += m)
+            out[v] = _popcount_avx2(rows, m);
+    }
+}
+
+/***** AVX-512 *****/
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static size_t _popcount_avx512(const setword* words, size_t nb_words) {
+    __m512i acc{_mm512_setzero_si512()};
+    size_t i{0};
+    for(; i+8 <= nb_words; i += 8)
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_loadu_si512(words+i)));
+    const __mmask8 tail{static_cast<__mmask8>((1u << (nb_words-i)) - 1)};
+    acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, words+i)));
+    alignas(64) size_t lanes[8];  // (_mm512_reduce_add_epi64 warns with GCC 12)
+    _mm512_store_si512(lanes, acc);
+    size_t ret{0};
+    for(auto lane : lanes)
+        ret += lane;
+    return ret;
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+static void _degrees_avx512(const graph* rows, size_t n, size_t m, size_t* out) {
+    if(m == 1) {  // one row per lane
+        size_t v{0};
+        for(; v+8 <= n; v += 8)
+            _mm512_storeu_si512(out+v, _mm512_popcnt_epi64(_mm512_loadu_si512(rows+v)));
+        const __mmask8 tail{static_cast<__mmask8>((1u << (n-v)) - 1)};
+        _mm512_mask_storeu_epi64(out+v, tail, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(tail, rows+v)));
+    } else {
+        for(size_t v{0}; v < n; ++v, rows += m)
+            out[v] = _popcount_avx512(rows, m);
+    }
+}
+
+#endif  // NAUTYPP_X86_KERNELS
+
+/***** Cliques *****/
+
+/* cand holds k sets of m words: cand[d] is the set of the vertices after the
+ * d-th vertex of the current clique which are adjacent to all of them.
+ * The depth-first search is iterative so that it can be inlined (with the
+ * popcounts) in a caller compiled for another instruction set. */
+template <bool SINGLE_WORD>
+[[gnu::always_inline]] static inline size_t _count_cliques(const graph* rows,
+        size_t n, size_t m, size_t k, size_t limit, setword* cand) {
+    const size_t words{SINGLE_WORD ? 1 : m};
+    auto level{[cand, words](size_t d) { return cand + d*words; }};
+    auto size{[words](const setword* S) {
+        size_t ret{0};
+        for(size_t i{0}; i < words; ++i)
+            ret += static_cast<size_t>(std::popcount(S[i]));
+        return ret;
+    }};
+    for(size_t i{0}; i < words; ++i) {  // every vertex is a candidate
+        const size_t first{i*WORDSIZE};
+        cand[i] = n >= first+WORDSIZE ? ~setword{0}
+            : n > first ? ~setword{0} << (WORDSIZE - (n-first))
+            : setword{0};
+    }
+    size_t ret{0};
+    for(size_t d{0}; ;) {
+        setword* S{level(d)};
+        if(d == k-1) {  // the last vertex can be any candidate
+            ret += size(S);
+            if(ret >= limit)
+                return limit;
+        } else if(size(S) >= k-d) {  // enough candidates to complete a clique
+            size_t i{0};
+            while(S[i] == 0)
+                ++i;
+            const auto b{std::countl_zero(S[i])};
+            S[i] &= ~(setword{1} << (WORDSIZE-1-b));  // the next candidates are after v
+            const graph* row{rows + (i*WORDSIZE + static_cast<size_t>(b))*words};
+            setword* next{level(d+1)};
+            for(size_t j{0}; j < words; ++j)
+                next[j] = S[j] & row[j];
+            ++d;
+            continue;
+        }
+        if(d == 0)
+            return ret;
+        --d;
+    }
+}
+
+template <bool SINGLE_WORD>
+static size_t _count_cliques_scalar(const graph* rows, size_t n, size_t m, size_t k,
+        size_t limit, setword* cand) {
+    return _count_cliques<SINGLE_WORD>(rows, n, m, k, limit, cand);
+}
+
+#if NAUTYPP_X86_KERNELS
+template <bool SINGLE_WORD>
+__attribute__((target("popcnt")))
+static size_t _count_cliques_popcnt(const graph* rows, size_t n, size_t m, size_t k,
+        size_t limit, setword* cand) {
+    return _count_cliques<SINGLE_WORD>(rows, n, m, k, limit, cand);
+}
+#endif
+
+/***** Dispatch *****/
+
+bool supported(Backend backend) {
+    switch(backend) {
+    case Backend::SCALAR:
+        return true;
+#if NAUTYPP_X86_KERNELS
+    case Backend::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case Backend::AVX512:
+        return __builtin_cpu_supports("avx512f") and __builtin_cpu_supports("avx512vpopcntdq");
+#endif
+    default:
+        return false;
+    }
+}
+
+Backend backend() {
+    static const Backend ret{
+        supported(Backend::AVX512) ? Backend::AVX512
+        : supported(Backend::AVX2) ? Backend::AVX2
+        : Backend::SCALAR
+    };
+    return ret;
+}
+
+const char* name(Backend backend) {
+    switch(backend) {
+    case Backend::AVX2:
+        return "avx2";
+    case Backend::AVX512:
+        return "avx512";
+    default:
+        return "scalar";
+    }
+}
+
+void degrees(Backend backend, const graph* rows, size_t n, size_t m, size_t* out) {
+    switch(backend) {
+#if NAUTYPP_X86_KERNELS
+    case Backend::AVX2:
+        return _degrees_avx2(rows, n, m, out);
+    case Backend::AVX512:
+        return _degrees_avx512(rows, n, m, out);
+#endif
+    default:
+        return _degrees_scalar(rows, n, m, out);
+    }
+}
+
+void degrees(const graph* rows, size_t n, size_t m, size_t* out) {
+    degrees(backend(), rows, n, m, out);
+}
+
+size_t count_cliques(const graph* rows, size_t n, size_t m, size_t k, size_t limit) {
+    if(k == 0)
+        return std::min<size_t>(1, limit);
+    if(k > n or limit == 0)
+        return 0;
+    static constexpr size_t STACK_WORDS{256};
+    setword stack[STACK_WORDS];
+    std::vector<setword> heap;
+    setword* cand{stack};
+    if(k*m > STACK_WORDS) {
+        heap.resize(k*m);
+        cand = heap.data();
+    }
+    auto count{m == 1 ? _count_cliques_scalar<true> : _count_cliques_scalar<false>};
+#if NAUTYPP_X86_KERNELS
+    if(backend() != Backend::SCALAR)  // every CPU with AVX2 has popcnt
+        count = m == 1 ? _count_cliques_popcnt<true> : _count_cliques_popcnt<false>;
+#endif
+    return count(rows, n, m, k, limit, cand);
+}
+
+size_t popcount(const setword* words, size_t nb_words) {
+    switch(backend()) {
+#if NAUTYPP_X86_KERNELS
+    case Backend::AVX2:
+        return _popcount_avx2(words, nb_words);
+    case Backend::AVX512:
+        return _popcount_avx512(words, nb_words);
+#endif
+    default:
+        return _popcount_scalar(words, nb_words);
+    }
+}
+
+}  // namespace nautypp::kernels
@@ -5,18 +5,30 @@
 using namespace nautypp;
 
 void _gentreeg_callback(FILE* f, int* par, int n) {
-    Nauty::get_container()->_add_gentree_tree(par, n);
+    auto container{Nauty::get_container()};
+    if(container->stop_requested())
+        throw Nauty::GenerationStopped{};
+    container->_add_gentree_tree(par, n);
     (void)f;
 }
 
 void _geng_callback(FILE* f, graph* g, int n) {
-    Nauty::get_container()->emplace(g, n, true);
+    Nauty::get_container()->output(g, static_cast<size_t>(n));
     (void)f;
 }
 
+int _geng_prune(graph* g, int n, int maxn) {
+    return Nauty::_prune(g, n, maxn) ? 1 : 0;
+}
+
+int _geng_preprune(graph* g, int n, int maxn) {
+    return Nauty::_preprune(g, n, maxn) ? 1 : 0;
+}
+
 namespace nautypp {
 
-std::unique_ptr<NautyContainer> Nauty::_container;
+thread_local NautyContainer* Nauty::_bound_container{nullptr};
+thread_local Nauty::PruningHooks Nauty::_bound_hooks;
 
 /***** EdgeIterator *****/
 
@@ -78,75 +90,35 @@ Graph::Graph(const graph* G, size_t V):
 }
 
 Graph::Graph(graph* G, size_t V, bool copy):
-        n{V}, host{copy},
+        n{V}, host{false},
         _m{SETWORDSNEEDED(n)},
         g{copy ? nullptr : G},
-        nb_edges(*this), degrees(),
-        _as_cliquer(*this) {
+        _properties() {
     if(copy)
         assign_from(G, V);
-    init_degrees();
-}
-
-#ifdef NAUTYPP_SGO
-Graph::Graph(size_t V):
-        n{V}, host{n > NAUTYPP_SMALL_GRAPH_SIZE},
-        _m{SETWORDSNEEDED(n)},
-        g{host ? new graph[_m*V] : __small_graph_buffer},
-        nb_edges(*this), degrees(),
-        _as_cliquer(*this) {
-    for(Vertex v{0}; v < n; ++v)
-        g[v] = 0;
-    init_degrees();
 }
 
-Graph::Graph(Graph&& G):
-        n{G.n}, host{G.host},
-        _m{SETWORDSNEEDED(n)},
-        g{
-            G.g != &G.__small_graph_buffer[0]
-            ? G.g
-            : __small_graph_buffer
-        },
-        nb_edges{std::move(G.nb_edges)},
-        degrees(std::move(G.degrees)),
-        _as_cliquer(*this) {
-    G.host = false;
-    if(g == __small_graph_buffer)
-        memcpy(g, G.g, _m*G.n*sizeof(graph));
-}
-#else
 Graph::Graph(size_t V):
-        n{V}, host{true},
-        _m{SETWORDSNEEDED(n)},
-        g{new graph[_m * V]},
-        nb_edges(*this), degrees(),
-        _as_cliquer(*this) {
-    for(Vertex v{0}; v < _m*V; ++v)
-        g[v] = 0;
-    init_degrees();
+        n{V}, host{false},
+        _m{SETWORDSNEEDED(n)}, g{nullptr},
+        _properties() {
+    allocate(n);
+    std::fill_n(g, _m*n, graph{0});
 }
 
 Graph::Graph(Graph&& G):
-        n{G.n}, host{G.host},
-        _m{G._m},
-        g{G.g}, nb_edges(std::move(G.nb_edges)),
-        degrees(std::move(G.degrees)),
-        _as_cliquer(*this) {
-    G.host = false;
-    G.g = nullptr;
-    for(size_t v{0}; v < n; ++v)
-        degrees[v].reset_graph(this);
-    nb_edges.reset_graph(this);
+        n{G.n}, host{false},
+        _m{G._m}, g{nullptr},
+        _properties(std::move(G._properties)) {
+    steal_rows(G);
 }
-#endif
 
 Graph::Graph(int* parents, size_t V):
-        n{V}, host{true},
+        n{V}, host{false},
         _m{SETWORDSNEEDED(n)}, g{nullptr},
-        nb_edges(*this), degrees(),
-        _as_cliquer(*this) {
-    g = new graph[_m*n]{0};
+        _properties() {
+    allocate(n);
+    std::fill_n(g, _m*n, graph{0});
     for(size_t v{2}; v <= V; ++v) {
         ADDONEEDGE(
             g, v-1,
@@ -157,18 +129,30 @@ Graph::Graph(int* parents, size_t V):
 }
 
 Graph& Graph::operator=(Graph&& other) {
+    if(this == &other)
+        return *this;
     reset();
-    _m = other._m;
-    g = other.g;
     n = other.n;
-    host = other.host;
-    nb_edges = std::move(other.nb_edges);
-    degrees = std::move(other.degrees);
-    other.host = false;
-    _as_cliquer.set_stale();
+    _m = other._m;
+    _properties = std::move(other._properties);
+    steal_rows(other);
     return *this;
 }
 
+void Graph::steal_rows(Graph& G) {
+    if(G.host) {  // heap: the rows change hands
+        g = G.g;
+        host = true;
+    } else if(G.g != nullptr) {  // inline or borrowed: the new graph must own a copy
+        assign_from(G.g, n);
+    } else {
+        g = nullptr;
+        host = false;
+    }
+    G.host = false;
+    G.g = nullptr;
+}
+
 Graph Graph::disjoint_union(const Graph& G1, const Graph& G2) {
     size_t new_size{G1.V() + G2.V()};
     Graph ret(new_size);
@@ -189,18 +173,6 @@ Graph Graph::complement() const {
     return ret;
 }
 
-Cliquer::Set Graph::find_some_clique(
-        size_t minsize, size_t maxsize,
-        bool maximal) const {
-    cliquer_graph_t* graph{*this};
-    set_t clique = clique_unweighted_find_single(
-        graph, minsize, maxsize, maximal, NULL
-    );
-    Cliquer::Set ret{clique};
-    set_free(clique);
-    return ret;
-}
-
 template <typename T>
 static inline std::remove_reference_t<std::remove_cv_t<T>>&
 _get_user_data_as_ref(clique_options* opts) {
@@ -209,6 +181,16 @@ _get_user_data_as_ref(clique_options* opts) {
     );
 }
 
+static inline Cliquer::Set _find_some_clique(cliquer_graph_t* graph,
+        size_t minsize, size_t maxsize, bool maximal) {
+    set_t clique = clique_unweighted_find_single(
+        graph, minsize, maxsize, maximal, NULL
+    );
+    Cliquer::Set ret{clique};
+    set_free(clique);
+    return ret;
+}
+
 static inline boolean _add_clique(set_t clique, cliquer_graph_t*, clique_options* opts) {
     _get_user_data_as_ref<std::vector<Cliquer::Set>>(opts).push_back(
         clique
@@ -216,7 +198,8 @@ static inline boolean _add_clique(set_t clique, cliquer_graph_t*, clique_options
     return true;
 }
 
-std::vector<Cliquer::Set> Graph::get_all_cliques(size_t minsize, size_t maxsize, bool maximal) const {
+static inline std::vector<Cliquer::Set> _get_all_cliques(cliquer_graph_t* graph,
+        size_t minsize, size_t maxsize, bool maximal) {
     std::vector<Cliquer::Set> cliques;
     clique_options opts = {
         .reorder_function=NULL,
@@ -228,10 +211,7 @@ std::vector<Cliquer::Set> Graph::get_all_cliques(size_t minsize, size_t maxsize,
         .clique_list=NULL,
         .clique_list_length=0
     };
-    clique_unweighted_find_all(
-        static_cast<cliquer_graph_t*>(*this),
-        minsize, maxsize, maximal, &opts
-    );
+    clique_unweighted_find_all(graph, minsize, maxsize, maximal, &opts);
     return cliques;
 }
 
@@ -242,46 +222,89 @@ static inline boolean _set_callback(set_t clique, cliquer_graph_t*, clique_optio
     );
 }
 
-size_t Graph::apply_to_cliques(size_t minsize, size_t maxsize, bool maximal,
-        std::function<bool(const Cliquer::Set&)> callback) const {
+static inline boolean _vector_callback(set_t clique, cliquer_graph_t*, clique_options* opts) {
+    typedef std::function<bool(const std::vector<Vertex>&)> VectorCallback;
+    return _get_user_data_as_ref<VectorCallback>(opts)(
+        static_cast<std::vector<Vertex>>(Cliquer::Set(clique, false))
+    );
+}
+
+template <typename Callback>
+static inline size_t _apply_to_cliques(cliquer_graph_t* graph,
+        size_t minsize, size_t maxsize, bool maximal,
+        Callback& callback,
+        boolean (*user_function)(set_t, cliquer_graph_t*, clique_options*)) {
     clique_options opts = {
         .reorder_function=NULL,
         .reorder_map=NULL,
         .time_function=NULL,
         .output=NULL,
-        .user_function=_set_callback,
+        .user_function=user_function,
         .user_data=&callback,
         .clique_list=NULL,
         .clique_list_length=0
     };
-    return clique_unweighted_find_all(
-        static_cast<cliquer_graph_t*>(*this),
-        minsize, maxsize, maximal, &opts
+    return clique_unweighted_find_all(graph, minsize, maxsize, maximal, &opts);
+}
+
+Cliquer::Set Graph::find_some_clique(
+        size_t minsize, size_t maxsize,
+        bool maximal) const {
+    return _find_some_clique(
+        static_cast<cliquer_graph_t*>(*this), minsize, maxsize, maximal
     );
 }
 
-static inline boolean _vector_callback(set_t clique, cliquer_graph_t*, clique_options* opts) {
-    typedef std::function<bool(const std::vector<Vertex>&)> VectorCallback;
-    return _get_user_data_as_ref<VectorCallback>(opts)(
-        static_cast<std::vector<Vertex>>(Cliquer::Set(clique, false))
+std::vector<Cliquer::Set> Graph::get_all_cliques(size_t minsize, size_t maxsize, bool maximal) const {
+    return _get_all_cliques(
+        static_cast<cliquer_graph_t*>(*this), minsize, maxsize, maximal
+    );
+}
+
+size_t Graph::apply_to_cliques(size_t minsize, size_t maxsize, bool maximal,
+        std::function<bool(const Cliquer::Set&)> callback) const {
+    return _apply_to_cliques(
+        static_cast<cliquer_graph_t*>(*this), minsize, maxsize, maximal,
+        callback, _set_callback
     );
 }
 
 size_t Graph::apply_to_cliques(size_t minsize, size_t maxsize, bool maximal,
         std::function<bool(const std::vector<Vertex>&)> callback) const {
-    clique_options opts = {
-        .reorder_function=NULL,
-        .reorder_map=NULL,
-        .time_function=NULL,
-        .output=NULL,
-        .user_function=_vector_callback,
-        .user_data=&callback,
-        .clique_list=NULL,
-        .clique_list_length=0
-    };
-    return clique_unweighted_find_all(
-        static_cast<cliquer_graph_t*>(*this),
-        minsize, maxsize, maximal, &opts
+    return _apply_to_cliques(
+        static_cast<cliquer_graph_t*>(*this), minsize, maxsize, maximal,
+        callback, _vector_callback
+    );
+}
+
+/***** GraphView *****/
+
+/* graph of cliquer converted from a view, freed at the end of the scope */
+struct _ViewAsCliquer {
+    cliquer_graph_t* graph;
+
+    ~_ViewAsCliquer() {
+        graph_free(graph);
+    }
+};
+
+Cliquer::Set GraphView::find_some_clique(size_t minsize, size_t maxsize,
+        bool maximal) const {
+    _ViewAsCliquer converted{to_cliquer()};
+    return _find_some_clique(converted.graph, minsize, maxsize, maximal);
+}
+
+std::vector<Cliquer::Set> GraphView::get_all_cliques(size_t minsize, size_t maxsize,
+        bool maximal) const {
+    _ViewAsCliquer converted{to_cliquer()};
+    return _get_all_cliques(converted.graph, minsize, maxsize, maximal);
+}
+
+size_t GraphView::apply_to_cliques(size_t minsize, size_t maxsize, bool maximal,
+        std::function<bool(const std::vector<Vertex>&)> callback) const {
+    _ViewAsCliquer converted{to_cliquer()};
+    return _apply_to_cliques(
+        converted.graph, minsize, maxsize, maximal, callback, _vector_callback
     );
 }
 
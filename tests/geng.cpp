@@ -1,4 +1,18 @@
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <catch2/catch.hpp>
 
@@ -96,6 +110,591 @@ $ for n in `seq 3 10`; do ./geng -uCt $n; done
     REQUIRE(count_graphs(params) == expected_count);
 }
 
+static inline bool has_triangle(const Graph& G, size_t) {
+    for(auto [v, w] : G.edges())
+        for(auto u : G.neighbours_of(w))
+            if(u != v and G.are_linked(u, v))
+                return true;
+    return false;
+}
+
+TEST_CASE("Prune graphs containing a triangle") {
+    // containing a triangle is hereditary: pruning must give the same graphs as -t
+    auto n = GENERATE(range(3, 9));
+    bool before_canonicity_test = GENERATE(false, true);
+    NautyParameters params{
+        .connected=false,
+        .triangle_free=true,
+        .V=n, .Vmax=n
+    };
+    auto expected_count{count_graphs(params)};
+    params.triangle_free = false;
+    if(before_canonicity_test)
+        params.preprune = has_triangle;
+    else
+        params.prune = has_triangle;
+    REQUIRE(count_graphs(params) == expected_count);
+}
+
+TEST_CASE("Count generated graphs with several producers") {
+    static std::vector<size_t> ns{
+        {5, 6, 7, 8, 9}
+    };
+    static std::vector<size_t> counts{
+        {34, 156, 1'044, 12'346, 274'668}
+    };
+    auto i = GENERATE(range(0, 5));
+    unsigned nb_producers = GENERATE(2, 3, 8);
+    NautyParameters params{
+        .connected=false,
+        .V=static_cast<int>(ns[i]), .Vmax=static_cast<int>(ns[i]),
+        .nb_producers=nb_producers
+    };
+    REQUIRE(count_graphs(params) == counts[i]);
+}
+
+struct EdgeCounter {
+    typedef std::map<size_t, size_t> ResultType;
+
+    EdgeCounter() = default;
+    EdgeCounter(ResultType&& result): counts(std::move(result)) {
+    }
+
+    void operator()(Graph& G) {
+        ++counts[G.E()];
+    }
+
+    void join(EdgeCounter&& other) {
+        for(auto [E, count] : other.counts)
+            counts[E] += count;
+    }
+
+    ResultType&& get() {
+        return std::move(counts);
+    }
+private:
+    ResultType counts;
+};
+
+TEST_CASE("Reduce the results of many workers") {
+    NautyParameters params{.connected=false, .V=7, .Vmax=7};
+    auto expected{Nauty().run_async<EdgeCounter>(params, 1)};
+    unsigned nb_workers = GENERATE(2, 3, 5, 8, 13, 64);
+    REQUIRE(Nauty().run_async<EdgeCounter>(params, nb_workers, 16) == expected);
+}
+
+TEST_CASE("Heavy-tailed callback with small buffers") {
+    // a few graphs are much slower to process than the others: idle workers
+    // must steal from the busy ones without losing nor duplicating any graph
+    std::atomic_size_t count{0};
+    std::atomic_size_t nb_edges{0};
+    unsigned nb_workers = GENERATE(2, 4, 7);
+    size_t buffer_size = GENERATE(1, 3, 64);
+    NautyParameters params{.connected=false, .V=6, .Vmax=6};
+    Nauty().run_async(
+        [&count, &nb_edges](const Graph& G) {
+            if(G.E() == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            ++count;
+            nb_edges += G.E();
+        },
+        params, nb_workers, buffer_size
+    );
+    REQUIRE(count == 156);
+    // graphs come in complementary pairs: 156 * 15 / 2 edges in total
+    REQUIRE(nb_edges == 156 * 15 / 2);
+}
+
+TEST_CASE("Graphs moved out of the callback outlive their buffer") {
+    std::mutex mutex;
+    std::vector<Graph> graphs;
+    NautyParameters params{.connected=false, .V=6, .Vmax=6};
+    Nauty().run_async(
+        [&mutex, &graphs](Graph& G) {
+            std::lock_guard lock(mutex);
+            graphs.push_back(std::move(G));
+        },
+        params, 4, 8
+    );
+    REQUIRE(graphs.size() == 156);
+    size_t nb_edges{0};
+    for(const auto& G : graphs) {
+        std::vector<std::pair<Vertex, Vertex>> edges(G.edges());
+        REQUIRE(edges.size() == G.E());
+        nb_edges += edges.size();
+    }
+    REQUIRE(nb_edges == 156 * 15 / 2);
+}
+
+TEST_CASE("Slabs of the buffers are recycled between runs") {
+    auto& slabs{SlabPool::instance()};
+    slabs.clear();
+    NautyParameters params{.connected=false, .V=7, .Vmax=7};
+    for(size_t run{0}; run < 3; ++run) {
+        std::atomic_size_t count{0};
+        Nauty().run_async([&count](const Graph&) { ++count; }, params, 4);
+        REQUIRE(count == 1'044);
+        REQUIRE(slabs.size() > 0);
+    }
+    REQUIRE(slabs.nb_reused() >= 2 * 4);
+    SECTION("Limit the recycled memory") {
+        slabs.set_limit(0);
+        REQUIRE(slabs.size() == 0);
+        const auto nb_reused{slabs.nb_reused()};
+        std::atomic_size_t count{0};
+        Nauty().run_async([&count](const Graph&) { ++count; }, params, 4);
+        REQUIRE(count == 1'044);
+        REQUIRE(slabs.size() == 0);
+        REQUIRE(slabs.nb_reused() == nb_reused);
+        slabs.set_limit(SlabPool::DEFAULT_LIMIT);
+    }
+}
+
+TEST_CASE("Merge shards") {
+    NautyParameters params{
+        .connected=false,
+        .V=7, .Vmax=8,
+        .nb_producers=2
+    };
+    auto expected{Nauty().run_async<EdgeCounter>(params)};
+
+    unsigned nb_shards = GENERATE(1, 3, 5);
+    std::vector<std::string> paths;
+    for(unsigned i{0}; i < nb_shards; ++i) {
+        paths.push_back("test_shard_" + std::to_string(i) + ".bin");
+        Nauty().run_shard<EdgeCounter>(params, i, nb_shards, paths.back());
+    }
+    REQUIRE(Nauty::merge_shards<EdgeCounter>(paths) == expected);
+    if(nb_shards > 1) {
+        auto incomplete{paths};
+        incomplete.pop_back();
+        REQUIRE_THROWS(Nauty::merge_shards<EdgeCounter>(incomplete));
+        incomplete.push_back(paths.front());
+        REQUIRE_THROWS(Nauty::merge_shards<EdgeCounter>(incomplete));
+    }
+    for(const auto& path : paths)
+        std::remove(path.c_str());
+}
+
+TEST_CASE("Corrupted sizes are reported as truncated streams") {
+    std::stringstream ss;
+    serialization::write<std::uint64_t>(ss, std::uint64_t{1} << 60);
+    serialization::write<std::uint32_t>(ss, 42);
+    const auto data{ss.str()};
+    std::istringstream vector_stream(data);
+    REQUIRE_THROWS_AS(
+        serialization::read<std::vector<std::uint32_t>>(vector_stream),
+        serialization::TruncatedStream
+    );
+    std::istringstream string_stream(data);
+    REQUIRE_THROWS_AS(serialization::read<std::string>(string_stream), serialization::TruncatedStream);
+}
+
+TEST_CASE("Stop the run from the callback") {
+    // 12'005'168 graphs on 10 vertices: the run must not go through all of them
+    std::atomic_size_t count{0};
+    NautyParameters params{.connected=false, .V=10, .Vmax=10, .nb_producers=2};
+    Nauty().run_async(
+        [&count](const Graph&) {
+            return ++count < 1'000 ? CallbackStatus::CONTINUE : CallbackStatus::STOP;
+        },
+        params, 4, 64
+    );
+    REQUIRE(count >= 1'000);
+    REQUIRE(count < 12'005'168);
+}
+
+TEST_CASE("Stop the run with a stop token") {
+    bool tree = GENERATE(false, true);
+    std::atomic_size_t count{0};
+    std::stop_source stop;
+    stop.request_stop();
+    NautyParameters params{.tree=tree, .connected=false, .V=9, .Vmax=9};
+    Nauty().run_async(
+        [&count](const Graph&) {
+            ++count;
+        },
+        params, 4, 64, stop.get_token()
+    );
+    REQUIRE(count == 0);
+}
+
+struct StoppingEdgeCounter : EdgeCounter {
+    using EdgeCounter::EdgeCounter;
+
+    CallbackStatus operator()(Graph& G) {
+        EdgeCounter::operator()(G);
+        return G.E() == 0 ? CallbackStatus::STOP : CallbackStatus::CONTINUE;
+    }
+};
+
+TEST_CASE("Stopped shards are not saved") {
+    NautyParameters params{.connected=false, .V=8, .Vmax=8};
+    const std::string path{"test_stopped_shard.bin"};
+    REQUIRE_THROWS(Nauty().run_shard<StoppingEdgeCounter>(params, 0, 1, path));
+    REQUIRE_FALSE(std::ifstream(path));
+}
+
+TEST_CASE("Invalid shards are rejected before the run starts") {
+    NautyParameters params{.connected=false, .V=6, .Vmax=6};
+    params.shard_index = GENERATE(0u, 1u, 3u);
+    params.shard_count = params.shard_index == 0 ? 0 : params.shard_index;
+    auto callback{[](const Graph&) {}};
+    REQUIRE_THROWS_AS(Nauty().run_async(callback, params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().run_async<EdgeCounter>(params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().run_inline(callback, params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().generate(params), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().spawn(callback, params, 2).get(), std::runtime_error);
+    const std::string path{"test_invalid_shard.bin"};
+    REQUIRE_THROWS_AS(
+        Nauty().run_shard<EdgeCounter>(params, params.shard_index, params.shard_count, path),
+        std::runtime_error
+    );
+    REQUIRE_FALSE(std::ifstream(path));
+}
+
+TEST_CASE("Pruning trees is rejected before the run starts") {
+    NautyParameters params{.tree=true, .V=8};
+    const bool before_canonicity_test = GENERATE(false, true);
+    if(before_canonicity_test)
+        params.preprune = has_triangle;
+    else
+        params.prune = has_triangle;
+    auto callback{[](const Graph&) {}};
+    REQUIRE_THROWS_AS(Nauty().run_async(callback, params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().run_async<EdgeCounter>(params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().run_inline(callback, params, 2), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().generate(params), std::runtime_error);
+    REQUIRE_THROWS_AS(Nauty().spawn(callback, params, 2).get(), std::runtime_error);
+}
+
+TEST_CASE("Batch callbacks") {
+    unsigned nb_workers = GENERATE(1, 4);
+    size_t buffer_size = GENERATE(1, 16, 1'000);
+    std::atomic_size_t count{0};
+    std::atomic_size_t nb_edges{0};
+    std::atomic_size_t nb_edges_from_rows{0};
+    NautyParameters params{.connected=false, .V=7, .Vmax=7, .nb_producers=2};
+    Nauty().run_async(
+        [&](GraphBatch& batch) {
+            count += batch.size();
+            for(size_t i{0}; i < batch.size(); ++i) {
+                const auto n{batch.order(i)};
+                size_t degrees{0};
+                for(size_t k{0}; k < SETWORDSNEEDED(n)*n; ++k)
+                    degrees += std::popcount(batch.rows(i)[k]);
+                nb_edges_from_rows += degrees / 2;
+            }
+            for(const Graph& G : batch)
+                nb_edges += G.E();
+        },
+        params, nb_workers, buffer_size
+    );
+    REQUIRE(count == 1'044);
+    REQUIRE(nb_edges == 1'044 * 21 / 2);
+    REQUIRE(nb_edges_from_rows == nb_edges);
+}
+
+TEST_CASE("View callbacks") {
+    unsigned nb_workers = GENERATE(1, 4);
+    std::atomic_size_t count{0};
+    std::atomic_size_t nb_edges{0};
+    NautyParameters params{.connected=false, .V=7, .Vmax=7, .nb_producers=2};
+    auto callback{[&count, &nb_edges](GraphView G) {
+        ++count;
+        nb_edges += G.E();
+    }};
+    SECTION("Workers") {
+        Nauty().run_async(callback, params, nb_workers, 16);
+    }
+    SECTION("Inline") {
+        Nauty().run_inline(callback, params, nb_workers);
+    }
+    REQUIRE(count == 1'044);
+    REQUIRE(nb_edges == 1'044 * 21 / 2);  // closed under complement
+}
+
+TEST_CASE("Stop the run from a batch callback") {
+    std::atomic_size_t count{0};
+    NautyParameters params{.connected=false, .V=10, .Vmax=10};
+    Nauty().run_async(
+        [&count](GraphBatch& batch) {
+            count += batch.size();
+            return CallbackStatus::STOP;
+        },
+        params, 4, 64
+    );
+    REQUIRE(count > 0);
+    REQUIRE(count < 12'005'168);
+}
+
+TEST_CASE("Inline runs") {
+    SECTION("Count graphs") {
+        unsigned nb_threads = GENERATE(1, 3);
+        std::atomic_size_t count{0};
+        NautyParameters params{.connected=false, .V=7, .Vmax=7};
+        Nauty().run_inline([&count](const Graph&) { ++count; }, params, nb_threads);
+        REQUIRE(count == 1'044);
+    }
+    SECTION("Count trees") {
+        reducers::Counter<> count;
+        NautyParameters params{.tree=true, .V=9};
+        Nauty().run_inline([&count](const Graph&) { ++count; }, params, 2);
+        REQUIRE(count.get() == 47);
+    }
+    SECTION("Stop from the callback") {
+        std::atomic_size_t count{0};
+        NautyParameters params{.connected=false, .V=10, .Vmax=10};
+        Nauty().run_inline(
+            [&count](const Graph&) {
+                return ++count < 1'000 ? CallbackStatus::CONTINUE : CallbackStatus::STOP;
+            },
+            params, 2
+        );
+        REQUIRE(count >= 1'000);
+        REQUIRE(count < 12'005'168);
+    }
+    SECTION("Stop with a stop token") {
+        std::atomic_size_t count{0};
+        std::stop_source stop;
+        stop.request_stop();
+        NautyParameters params{.connected=false, .V=9, .Vmax=9};
+        Nauty().run_inline([&count](const Graph&) { ++count; }, params, 2, stop.get_token());
+        REQUIRE(count == 0);
+    }
+}
+
+TEST_CASE("Pipeline statistics") {
+    std::ostringstream summary;
+    PipelineStatistics statistics(&summary);
+    NautyParameters params{
+        .connected=false, .V=7, .Vmax=7, .nb_producers=2, .statistics=&statistics
+    };
+    SECTION("Graph callback") {
+        std::atomic_size_t count{0};
+        Nauty().run_async(
+            [&count](const Graph&) {
+                ++count;
+            },
+            params, 3, 16
+        );
+        REQUIRE(count == 1'044);
+    }
+    SECTION("Batch callback") {
+        Nauty().run_async([](GraphBatch&) {}, params, 3, 16);
+    }
+    SECTION("Callback given by type") {
+        Nauty().run_async<EdgeCounter>(params, 3, 16);
+    }
+    const auto snapshot{statistics.snapshot()};
+    REQUIRE(snapshot.over);
+    REQUIRE(snapshot.producers.size() == 2);
+    REQUIRE(snapshot.workers.size() == 3);
+    REQUIRE(snapshot.produced() == 1'044);
+    REQUIRE(snapshot.consumed() == 1'044);
+    for(const auto& producer : snapshot.producers) {
+        REQUIRE(producer.over);
+        REQUIRE(std::accumulate(
+            producer.occupancy.begin(), producer.occupancy.end(), std::uint64_t{0}
+        ) == producer.produced);
+        REQUIRE(PipelineStatistics::quantile(producer.occupancy, 1.) >= 1);
+        REQUIRE(PipelineStatistics::quantile(producer.occupancy, 1.) < 32);
+    }
+    for(const auto& worker : snapshot.workers) {
+        REQUIRE(worker.stolen <= worker.consumed);
+        REQUIRE(std::accumulate(
+            worker.call_time.begin(), worker.call_time.end(), std::uint64_t{0}
+        ) == worker.calls);
+    }
+    REQUIRE(summary.str().find("1044 graphs produced, 1044 processed") != std::string::npos);
+}
+
+static inline size_t count_occurrences(const std::string& s, const std::string& pattern) {
+    size_t ret{0};
+    for(auto pos{s.find(pattern)}; pos != std::string::npos; pos = s.find(pattern, pos+1))
+        ++ret;
+    return ret;
+}
+
+TEST_CASE("Chrome trace of a run") {
+    NautyParameters params{.connected=false, .V=7, .Vmax=7, .nb_producers=2};
+    SECTION("Every call sampled") {
+        PipelineTrace trace("", 1 << 12, 1);
+        params.trace = &trace;
+        Nauty().run_async([](const Graph&) {}, params, 3, 16);
+        std::ostringstream os;
+        trace.write(os);
+        const auto json{os.str()};
+        REQUIRE(json.starts_with("{\"displayTimeUnit\""));
+        REQUIRE(json.ends_with("]}\n"));
+        REQUIRE(count_occurrences(json, "\"name\":\"callback\"") == 1'044);
+        REQUIRE(count_occurrences(json, "\"name\":\"produce\"") >= 2);
+        REQUIRE(json.find("\"name\":\"nauty-geng-2\"") != std::string::npos);
+        REQUIRE(json.find("\"name\":\"Worker 3\"") != std::string::npos);
+    }
+    SECTION("Only the most recent events are kept") {
+        PipelineTrace trace("", 4, 1);
+        params.trace = &trace;
+        Nauty().run_async<EdgeCounter>(params, 3, 16);
+        std::ostringstream os;
+        trace.write(os);
+        REQUIRE(count_occurrences(os.str(), "\"cat\":\"worker\"") <= 3*4);
+        REQUIRE(count_occurrences(os.str(), "\"cat\":\"producer\"") <= 2*4);
+    }
+}
+
+TEST_CASE("Place the threads of a run") {
+    SECTION("Parse CPU lists") {
+        REQUIRE(numa::parse_cpu_list("0-3,8,10-11\n") == std::vector<int>{0, 1, 2, 3, 8, 10, 11});
+        REQUIRE(numa::parse_cpu_list("").empty());
+    }
+    SECTION("Unpinned threads") {
+        const auto plan{CpuPlan::make(ThreadPlacement{}, 2, 3)};
+        REQUIRE(plan.producer(1) == -1);
+        REQUIRE(plan.worker(2) == -1);
+        REQUIRE(plan.buffer(0) == -1);
+    }
+    SECTION("Explicit CPUs") {
+        const auto plan{CpuPlan::make(
+            ThreadPlacement{.pin=true, .producer_cpus={0}, .worker_cpus={0, 1}}, 2, 3
+        )};
+        REQUIRE(plan.producer(1) == 0);
+        REQUIRE(plan.worker(2) == 0);
+        REQUIRE(plan.buffer(1) == 1);
+    }
+    SECTION("Workers share the node of their producer") {
+        const auto nodes{numa::nodes()};
+        const auto plan{CpuPlan::make(ThreadPlacement{.pin=true}, 2, 5)};
+        auto node_of{[&nodes](int cpu) {
+            for(size_t node{0}; node < nodes.size(); ++node)
+                if(std::find(nodes[node].begin(), nodes[node].end(), cpu) != nodes[node].end())
+                    return node;
+            return nodes.size();
+        }};
+        for(size_t i{0}; i < 5; ++i) {
+            REQUIRE(node_of(plan.worker(i)) < nodes.size());
+            REQUIRE(node_of(plan.worker(i)) == node_of(plan.producer(i % 2)));
+        }
+    }
+    SECTION("Pinned run") {
+        const auto cpu{numa::allowed_cpus().front()};
+        NautyParameters params{
+            .connected=false, .V=7, .Vmax=7, .nb_producers=2,
+            .placement={.pin=true, .producer_cpus={cpu}, .worker_cpus={cpu}}
+        };
+        REQUIRE(count_graphs(params) == 1'044);
+        params.placement = ThreadPlacement{.pin=true};
+        REQUIRE(count_graphs(params) == 1'044);
+    }
+}
+
+TEST_CASE("Spawn concurrent runs") {
+    NautyParameters params7{.connected=false, .V=7, .Vmax=7};
+    NautyParameters params8{.connected=false, .V=8, .Vmax=8, .nb_producers=2};
+    auto expected7{Nauty().run_async<EdgeCounter>(params7)};
+    auto expected8{Nauty().run_async<EdgeCounter>(params8)};
+
+    std::atomic_size_t count{0};
+    auto counting{Nauty().spawn(
+        [&count](const Graph&) {
+            ++count;
+        },
+        params8, 2
+    )};
+    auto handle7{Nauty().spawn<EdgeCounter>(params7, 3)};
+    auto handle8{Nauty().spawn<EdgeCounter>(params8, 3)};
+    REQUIRE(handle7.get() == expected7);
+    REQUIRE(handle8.get() == expected8);
+    counting.wait();
+    REQUIRE(counting.poll());
+    REQUIRE(count == 12'346);
+}
+
+TEST_CASE("Stop a spawned run") {
+    // 12'005'168 graphs on 10 vertices
+    std::atomic_size_t count{0};
+    auto handle{Nauty().spawn(
+        [&count](const Graph&) {
+            ++count;
+        },
+        NautyParameters{.connected=false, .V=10, .Vmax=10}, 2, 64
+    )};
+    while(count == 0)
+        std::this_thread::yield();
+    handle.request_stop();
+    handle.wait();
+    REQUIRE(count < 12'005'168);
+}
+
+TEST_CASE("Concurrent blocking runs are independent") {
+    std::atomic_size_t count8{0};
+    std::atomic_size_t count_file{0};
+    std::thread other([&count8]() {
+        NautyParameters params{.connected=false, .V=8, .Vmax=8, .nb_producers=2};
+        Nauty().run_async(
+            [&count8](const Graph&) {
+                ++count8;
+            },
+            params, 3
+        );
+    });
+    Nauty nauty;
+    std::thread reader([&nauty, &count_file]() {
+        nauty.run_async(
+            [&count_file](const Graph&) {
+                ++count_file;
+            },
+            "geng_4_biconnected.graph6", 4, 2
+        );
+    });
+    const auto count7{count_graphs(NautyParameters{.connected=false, .V=7, .Vmax=7})};
+    other.join();
+    reader.join();
+    REQUIRE(count7 == 1'044);
+    REQUIRE(count8 == 12'346);
+    REQUIRE(count_file == 3);
+}
+
+TEST_CASE("Iterate over generated graphs") {
+    unsigned nb_producers = GENERATE(1, 3);
+    size_t buffer_size = GENERATE(1, 64);
+    NautyParameters params{
+        .connected=false,
+        .V=7, .Vmax=7,
+        .nb_producers=nb_producers
+    };
+    size_t count{0};
+    size_t nb_edges{0};
+    for(const Graph& G : Nauty().generate(params, buffer_size)) {
+        ++count;
+        nb_edges += G.E();
+    }
+    REQUIRE(count == 1'044);
+    // graphs come in complementary pairs
+    REQUIRE(nb_edges == 1'044 * 21 / 2);
+}
+
+TEST_CASE("Leave the iteration over generated graphs early") {
+    // 12'005'168 graphs on 10 vertices: geng must be stopped
+    NautyParameters params{.connected=false, .V=10, .Vmax=10, .nb_producers=2};
+    size_t count{0};
+    for(auto& G : Nauty().generate(params, 16)) {
+        (void)G;
+        if(++count == 100)
+            break;
+    }
+    REQUIRE(count == 100);
+}
+
+TEST_CASE("Iterate over the graphs of a file") {
+    size_t count{0};
+    for(const Graph& G : Nauty().generate("geng_4_biconnected.graph6", 4)) {
+        REQUIRE(G.V() == 4);
+        ++count;
+    }
+    REQUIRE(count == 3);
+}
+
 TEST_CASE("Read graph6") {
     Nauty nauty;
     std::atomic_int count{0};
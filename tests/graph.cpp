@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <numeric>
+#include <random>
 
 #include <catch2/catch.hpp>
 
@@ -119,3 +121,237 @@ TEST_CASE("Big graphs") {
         REQUIRE(expected_neighbours == Nv);
     }
 }
+
+TEST_CASE("Views agree with their graph") {
+    auto G{Graph::disjoint_union(
+        Graph::make_complete_bipartite(3, 4),
+        Graph::disjoint_union(Graph::make_complete(5), Graph::make_path(70))
+    )};
+    const auto view{G.view()};
+    REQUIRE(view.V() == G.V());
+    REQUIRE(view.E() == G.E());
+    REQUIRE(view.degree() == G.degree());
+    REQUIRE(view.delta_Delta() == std::make_pair(G.delta(), G.Delta()));
+    REQUIRE(view.degree_distribution() == G.degree_distribution());
+    for(Vertex v{0}; v < G.V(); ++v) {
+        REQUIRE(std::vector<Vertex>(view.neighbours_of(v)) == std::vector<Vertex>(G.neighbours_of(v)));
+        REQUIRE(view.is_leaf(v) == G.is_leaf(v));
+    }
+    REQUIRE(std::vector<std::pair<Vertex, Vertex>>(view.edges())
+         == std::vector<std::pair<Vertex, Vertex>>(G.edges()));
+    REQUIRE(view.nb_connected_components() == 3);
+    REQUIRE_FALSE(view.is_connected());
+    REQUIRE(view.max_clique() == G.max_clique());
+    REQUIRE(view.get_all_cliques(5, 5, false).size() == 1);
+    REQUIRE(view.is_planar() == G.is_planar());
+    REQUIRE(Graph::make_complete(4).view().is_planar());
+    REQUIRE_FALSE(Graph::make_complete(5).view().is_planar());
+
+    auto H{view.copy()};
+    REQUIRE(H.E() == G.E());
+    REQUIRE(H.view().rows() != view.rows());
+}
+
+TEST_CASE("Views of the empty graph") {
+    Graph G(4);
+    const auto view{G.view()};
+    REQUIRE(view.E() == 0);
+    REQUIRE(view.edges().begin() == view.edges().end());
+    REQUIRE(view.neighbours_of(2).begin() == view.neighbours_of(2).end());
+    REQUIRE(view.nb_connected_components() == 4);
+}
+
+TEST_CASE("Small graphs agree with their graph") {
+    static_assert(SmallGraph<8>::make_cycle(5).E() == 5);
+    static_assert(SmallGraph<8>::make_path(4).complement().is_connected());
+    static_assert(SmallGraph<8>(6).nb_connected_components() == 6);
+    size_t n = GENERATE(2, 7, 33, 64);
+    auto G{Graph::disjoint_union(Graph::make_path(n/2), Graph::make_complete(n - n/2))};
+    const Graph64 small(G);
+    REQUIRE(small.V() == G.V());
+    REQUIRE(small.E() == G.E());
+    REQUIRE(small.degree() == G.degree());
+    REQUIRE(small.delta_Delta() == std::make_pair(G.delta(), G.Delta()));
+    REQUIRE(small.nb_connected_components() == G.nb_connected_components());
+    for(Vertex v{0}; v < G.V(); ++v) {
+        REQUIRE(std::vector<Vertex>(small.neighbours_of(v)) == std::vector<Vertex>(G.neighbours_of(v)));
+        REQUIRE(std::vector<Vertex>(small.component_of(v))
+             == G.get_connected_components().get_component_of(v));
+    }
+    const auto complement{small.complement()};
+    const auto expected{G.complement()};
+    for(Vertex v{0}; v < G.V(); ++v)
+        for(Vertex w{0}; w < G.V(); ++w)
+            REQUIRE(complement.are_linked(v, w) == expected.are_linked(v, w));
+    REQUIRE(complement.complement() == small);
+    REQUIRE(Graph64(small.to_graph()) == small);
+    if(n > 4)
+        REQUIRE_THROWS(SmallGraph<4>(G.view()));
+}
+
+TEST_CASE("Small graphs are stored inline") {
+    size_t n = GENERATE(1, 5, NAUTYPP_SMALL_GRAPH_SIZE, NAUTYPP_SMALL_GRAPH_SIZE+1, 100);
+    const bool small{n <= NAUTYPP_SMALL_GRAPH_SIZE};
+    auto G{Graph::make_path(n)};
+    REQUIRE(G.is_inline() == small);
+    const auto rows{G.view().rows()};
+
+    Graph moved(std::move(G));
+    REQUIRE(moved.is_inline() == small);
+    REQUIRE(moved.E() == n-1);
+    if(not small)
+        REQUIRE(moved.view().rows() == rows);  // heap rows change hands
+
+    auto assigned{Graph::make_complete(2)};
+    assigned = std::move(moved);
+    REQUIRE(assigned.is_inline() == small);
+    REQUIRE(assigned.E() == n-1);
+    REQUIRE(assigned.degree(0) == (n > 1 ? 1 : 0));
+
+    const auto copy{assigned.copy()};
+    REQUIRE(copy.is_inline() == small);
+    REQUIRE(copy.E() == n-1);
+    REQUIRE(copy.view().rows() != assigned.view().rows());
+
+    std::vector<int> parents(n+1, 1);  // star rooted at 1 (gentreeg uses 1..n)
+    Graph star(parents.data(), n);
+    REQUIRE(star.is_inline() == small);
+    REQUIRE(star.E() == n-1);
+}
+
+TEST_CASE("Cached properties follow the graph") {
+    size_t n = GENERATE(5, 70, 130);
+    auto G{Graph::make_cycle(n)};
+    REQUIRE(G.E() == n);
+    REQUIRE(G.degree(n-1) == 2);
+
+    Graph moved(std::move(G));
+    REQUIRE(moved.E() == n);
+    moved.link(0, n/2);
+    REQUIRE(moved.degree(0) == 3);
+    REQUIRE(moved.degree(n/2) == 3);
+    REQUIRE(moved.degree(1) == 2);
+    REQUIRE(moved.E() == n+1);
+
+    moved.isolate_vertex(n/2);
+    REQUIRE(moved.degree(n/2) == 0);
+    REQUIRE(moved.degree(0) == 2);
+    REQUIRE(moved.E() == n-2);
+    REQUIRE(moved.degree() == moved.view().degree());
+}
+
+TEST_CASE("Edits keep the cached properties up to date") {
+    size_t n = GENERATE(7, 100);
+    Graph G(n);
+    REQUIRE(G.E() == 0);
+    REQUIRE(G.degree(0) == 0);
+    std::mt19937 rng(n);
+    std::uniform_int_distribution<Vertex> vertex(0, n-1);
+    for(size_t edit{0}; edit < 1'000; ++edit) {
+        const auto v{vertex(rng)}, w{vertex(rng)};
+        if(v == w)
+            continue;
+        if(edit % 3 == 0)
+            G.remove_edge(v, w);
+        else
+            G.add_edge(v, w);
+        REQUIRE(G.are_linked(v, w) == (edit % 3 != 0));
+        if(edit % 50 == 0)
+            G.isolate_vertex(v);
+        REQUIRE(G.degree(v) == G.view().degree(v));
+        REQUIRE(G.degree(w) == G.view().degree(w));
+        REQUIRE(G.E() == G.view().E());
+    }
+    REQUIRE(G.degree() == G.view().degree());
+}
+
+TEST_CASE("Degree kernels agree with popcounts") {
+    size_t n = GENERATE(1, 3, 8, 13, 64, 65, 130, 300);
+    Graph G(n);
+    std::mt19937 rng(n);
+    std::bernoulli_distribution coin(.3);
+    for(Vertex v{0}; v < n; ++v)
+        for(Vertex w{v+1}; w < n; ++w)
+            if(coin(rng))
+                G.link(v, w);
+    std::vector<size_t> expected(n);
+    for(Vertex v{0}; v < n; ++v)
+        expected[v] = G.degree(v);
+
+    for(auto backend : {kernels::Backend::SCALAR, kernels::Backend::AVX2, kernels::Backend::AVX512}) {
+        if(not kernels::supported(backend))
+            continue;
+        INFO("backend: " << kernels::name(backend));
+        std::vector<size_t> degrees(n);
+        kernels::degrees(backend, G.view().rows(), n, G.view().m(), degrees.data());
+        REQUIRE(degrees == expected);
+    }
+
+    std::vector<size_t> degrees(n);
+    G.degree(degrees);
+    REQUIRE(degrees == expected);
+    REQUIRE(G.degree() == expected);
+    REQUIRE(2*G.E() == std::accumulate(expected.begin(), expected.end(), size_t{0}));
+    auto [min_it, max_it] = std::minmax_element(expected.begin(), expected.end());
+    REQUIRE(G.delta_Delta() == std::make_pair(*min_it, *max_it));
+    std::vector<size_t> counts(n, 1);
+    G.degree_distribution(counts);
+    for(size_t d{0}; d < n; ++d)
+        REQUIRE(counts[d] == static_cast<size_t>(std::count(expected.begin(), expected.end(), d)));
+}
+
+TEST_CASE("Count small cliques") {
+    SECTION("Complete graphs") {
+        size_t n = GENERATE(1, 4, 10, 64, 70);
+        const auto K{Graph::make_complete(n)};
+        REQUIRE(K.nb_cliques(0) == 1);
+        REQUIRE(K.nb_cliques(1) == n);
+        REQUIRE(K.nb_cliques(2) == binom2(n));
+        REQUIRE(K.nb_triangles() == n*(n-1)*(n-2) / 6);
+        REQUIRE(K.nb_K4() == n*(n-1)*(n-2)*(n-3) / 24);
+        REQUIRE(K.has_clique(n));
+        REQUIRE(not K.has_clique(n+1));
+        REQUIRE(K.view().nb_cliques(n) == 1);
+    }
+    SECTION("Triangle-free graphs") {
+        size_t n = GENERATE(3, 9, 100);
+        const auto G{Graph::make_complete_bipartite(n, n)};
+        REQUIRE(G.nb_cliques(2) == n*n);
+        REQUIRE(G.nb_triangles() == 0);
+        REQUIRE(not G.has_triangle());
+        REQUIRE(not Graph::make_cycle(n+1).has_triangle());
+        REQUIRE(Graph::make_cycle(3).has_triangle());
+    }
+    SECTION("Random graphs") {
+        size_t n = GENERATE(6, 40, 64, 65, 90);
+        Graph G(n);
+        std::mt19937 rng(n);
+        std::bernoulli_distribution coin(.5);
+        for(Vertex v{0}; v < n; ++v)
+            for(Vertex w{v+1}; w < n; ++w)
+                if(coin(rng))
+                    G.link(v, w);
+        size_t nb_triangles{0}, nb_K4{0};
+        for(Vertex u{0}; u < n; ++u)
+            for(Vertex v{u+1}; v < n; ++v)
+                if(G.are_linked(u, v))
+                    for(Vertex w{v+1}; w < n; ++w)
+                        if(G.are_linked(u, w) and G.are_linked(v, w)) {
+                            ++nb_triangles;
+                            for(Vertex x{w+1}; x < n; ++x)
+                                if(G.are_linked(u, x) and G.are_linked(v, x) and G.are_linked(w, x))
+                                    ++nb_K4;
+                        }
+        REQUIRE(G.nb_triangles() == nb_triangles);
+        REQUIRE(G.nb_K4() == nb_K4);
+        REQUIRE(G.has_triangle() == (nb_triangles > 0));
+        REQUIRE(G.has_clique(4) == (nb_K4 > 0));
+        for(size_t k{5}; k < 10; ++k)
+            REQUIRE(G.has_clique(k) == (G.nb_cliques(k) > 0));
+    }
+    SECTION("Cliques larger than the stack buffer") {
+        const auto K{Graph::make_complete(300)};
+        REQUIRE(K.has_clique(60));
+        REQUIRE(K.nb_cliques(299) == 300);
+    }
+}
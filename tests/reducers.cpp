@@ -0,0 +1,65 @@
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <nautypp/nautypp>
+
+using namespace nautypp;
+
+TEST_CASE("Reducers merge the shards of every thread") {
+    reducers::Counter<> count;
+    reducers::Histogram<> histogram;
+    reducers::Minimum<int, size_t> minimum;
+    reducers::Maximum<int> maximum;
+    reducers::KeyedMap<std::string, size_t> map;
+    constexpr size_t nb_threads{8};
+    constexpr int per_thread{1'000};
+    std::vector<std::thread> threads;
+    for(size_t t{0}; t < nb_threads; ++t) {
+        threads.emplace_back([&, t]() {
+            for(int i{0}; i < per_thread; ++i) {
+                ++count;
+                histogram.add(i % 5);
+                minimum.update(i - static_cast<int>(t), t);
+                maximum.update(i + static_cast<int>(t));
+                ++map[i % 2 == 0 ? "even" : "odd"];
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    REQUIRE(count.get() == nb_threads * per_thread);
+    REQUIRE(histogram.get() == std::vector<size_t>(5, nb_threads * per_thread / 5));
+    REQUIRE(minimum.get()->first == -static_cast<int>(nb_threads-1));
+    REQUIRE(minimum.get()->second == nb_threads-1);
+    REQUIRE(maximum.get()->first == per_thread-1 + static_cast<int>(nb_threads-1));
+    auto counts{map.get()};
+    REQUIRE(counts.size() == 2);
+    REQUIRE(counts["even"] == nb_threads * per_thread / 2);
+    REQUIRE(counts["odd"] == nb_threads * per_thread / 2);
+
+    count.clear();
+    REQUIRE(count.get() == 0);
+    REQUIRE_FALSE(reducers::Maximum<int>().get().has_value());
+}
+
+TEST_CASE("Reducers in lambda callbacks") {
+    reducers::Counter<> count;
+    reducers::Histogram<> nb_edges;
+    NautyParameters params{.connected=false, .V=7, .Vmax=7, .nb_producers=2};
+    Nauty().run_async(
+        [&count, &nb_edges](const Graph& G) {
+            ++count;
+            nb_edges.add(G.E());
+        },
+        params, 4
+    );
+    REQUIRE(count == 1'044);
+    auto histogram{nb_edges.get()};
+    REQUIRE(histogram.size() == 22);
+    // graphs come in complementary pairs
+    for(size_t E{0}; E <= 21; ++E)
+        REQUIRE(histogram[E] == histogram[21-E]);
+}